@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+# CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+#
+# Local network soak for the movement prediction pipeline.
+# Starts a dedicated server and a number of clients on loopback, all with the same simulated packet lag, loss and jitter,
+# lets UTutNetSoakSubsystem drive every client's character through the movement script, then prints each process's summary line.
+#
+# Usage: Scripts/NetSoak.sh [clean|average|bad] [clients] [seconds]
+# Set UE_EDITOR to the UnrealEditor binary if it isn't on the PATH. Packet simulation needs a non-shipping build.
+# NET_SOAK_EXTRA_ARGS is added to every process's command line.
+
+set -euo pipefail
+
+PROFILE="${1:-average}"
+CLIENTS="${2:-4}"
+SECONDS_TO_RUN="${3:-120}"
+
+EDITOR="${UE_EDITOR:-UnrealEditor}"
+PROJECT="$(cd "$(dirname "$0")/.." && pwd)/TutorialResearch.uproject"
+MAP="/Game/ThirdPerson/Maps/ThirdPersonMap"
+PORT=7787
+
+# Lag is one way, in ms. Loss is a percentage. Jitter is in ms.
+case "$PROFILE" in
+	clean)   NET_ARGS="-PktLag=0 -PktLoss=0 -PktJitter=0" ;;
+	average) NET_ARGS="-PktLag=50 -PktLoss=1 -PktJitter=10" ;;
+	bad)     NET_ARGS="-PktLag=150 -PktLoss=5 -PktJitter=40" ;;
+	*) echo "Unknown profile '$PROFILE', expected clean, average or bad." >&2; exit 1 ;;
+esac
+
+LOG_DIR="$(dirname "$PROJECT")/Saved/NetSoak/$PROFILE-$(date +%Y%m%d-%H%M%S)"
+mkdir -p "$LOG_DIR"
+
+SOAK_ARGS="-TutNetSoak -nullrhi -nosound -unattended -log $NET_ARGS ${NET_SOAK_EXTRA_ARGS:-}"
+
+echo "Net soak: profile $PROFILE ($NET_ARGS), $CLIENTS clients, ${SECONDS_TO_RUN}s. Logs in $LOG_DIR"
+
+# The server runs a little longer, so it's still there when the last client reports.
+"$EDITOR" "$PROJECT" "$MAP" -server -Port=$PORT $SOAK_ARGS -TutNetSoakSeconds=$((SECONDS_TO_RUN + 15)) \
+	-abslog="$LOG_DIR/Server.log" > /dev/null 2>&1 &
+PIDS=($!)
+
+sleep 10
+
+for ((i = 0; i < CLIENTS; i++)); do
+	"$EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game $SOAK_ARGS -TutNetSoakSeconds=$SECONDS_TO_RUN -abslog="$LOG_DIR/Client$i.log" > /dev/null 2>&1 &
+	PIDS+=($!)
+done
+
+for PID in "${PIDS[@]}"; do
+	wait "$PID" || true
+done
+
+grep -h "TutNetSoakSummary" "$LOG_DIR"/*.log || echo "No summaries found, check the logs in $LOG_DIR." >&2
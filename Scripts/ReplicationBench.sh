@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+#
+# Server replication cost, comparing two replication setups at a large number of characters.
+# Runs Scripts/NetSoak.sh twice on a clean network and prints both server summaries:
+#   pushmodel: net.IsPushModelEnabled=1, then 0.
+#   iris:      net.Iris.UseIrisReplication=1 (Iris), then 0 (generic replication). Needs a source engine build made with TUT_USE_IRIS=1, see the README.
+# Compare NetFlushMs (time the server spends in the net driver's flush per frame, mostly replication), GameThreadMs and OutBytes.
+#
+# Usage: Scripts/ReplicationBench.sh [pushmodel|iris] [clients] [seconds] [bots]
+# Bots are characters the server spawns and drives itself, so N characters can be replicated without N client processes.
+# 100 clients means 101 processes on this machine, so give it a machine with the cores and memory for that, or use fewer clients and more bots.
+
+set -euo pipefail
+
+MODE="${1:-pushmodel}"
+CLIENTS="${2:-100}"
+SECONDS_TO_RUN="${3:-90}"
+BOTS="${4:-0}"
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+case "$MODE" in
+	pushmodel) CVAR="net.IsPushModelEnabled" ;;
+	iris)      CVAR="net.Iris.UseIrisReplication" ;;
+	*) echo "Unknown mode '$MODE', use pushmodel or iris." >&2; exit 1 ;;
+esac
+
+for VALUE in 1 0; do
+	echo "=== $CVAR=$VALUE, $CLIENTS clients, $BOTS bots ==="
+	NET_SOAK_EXTRA_ARGS="-ini:Engine:[SystemSettings]:$CVAR=$VALUE -TutNetSoakBots=$BOTS" \
+		"$SCRIPT_DIR/NetSoak.sh" clean "$CLIENTS" "$SECONDS_TO_RUN" | grep -E "Net soak:|Role=Server" || true
+done
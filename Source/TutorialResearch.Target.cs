@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 using UnrealBuildTool;
+using System;
 using System.Collections.Generic;
 
 public class TutorialResearchTarget : TargetRules
@@ -10,6 +11,13 @@ public class TutorialResearchTarget : TargetRules
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_1;
+		//Iris changes how engine modules are compiled, which needs a unique build environment, and those need a source build of the engine.
+		//Off by default so the project still builds against a launcher engine. Set TUT_USE_IRIS=1 before building to compile it in.
+		if (Environment.GetEnvironmentVariable("TUT_USE_IRIS") == "1")
+		{
+			bUseIris = true;
+			BuildEnvironment = TargetBuildEnvironment.Unique;
+		}
 		ExtraModuleNames.Add("TutorialResearch");
 	}
 }
@@ -0,0 +1,11 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "MyCustomAICharacter.h"
+#include "TutAIMovementComponent.h"
+
+//Our parent asks for UTutCharacterMovementComponent too. The most derived class wins, as long as it is a child of what the parents ask for.
+AMyCustomAICharacter::AMyCustomAICharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UTutAIMovementComponent>(ACharacter::CharacterMovementComponentName))
+{
+	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
+}
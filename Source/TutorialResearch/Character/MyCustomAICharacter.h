@@ -0,0 +1,20 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MyCustomCharacter.h"
+#include "MyCustomAICharacter.generated.h"
+
+/*
+* AMyCustomCharacter for AI. Uses UTutAIMovementComponent, and is possessed by an AI controller when placed or spawned.
+*/
+UCLASS()
+class TUTORIALRESEARCH_API AMyCustomAICharacter : public AMyCustomCharacter
+{
+	GENERATED_BODY()
+
+public:
+
+	AMyCustomAICharacter(const FObjectInitializer& ObjectInitializer);
+};
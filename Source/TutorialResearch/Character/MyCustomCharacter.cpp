@@ -3,10 +3,14 @@
 
 #include "MyCustomCharacter.h"
 #include "TutCharacterMovementComponent.h"
+#include "TutMovementStats.h"
+#include "TutCharacterComponents.h"
 
 
 AMyCustomCharacter::AMyCustomCharacter(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer.SetDefaultSubobjectClass<UTutCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UTutCharacterMovementComponent>(ACharacter::CharacterMovementComponentName)
+		.SetDefaultSubobjectClass<UTutCapsuleComponent>(ACharacter::CapsuleComponentName)
+		.SetDefaultSubobjectClass<UTutSkeletalMeshComponent>(ACharacter::MeshComponentName))
 {
 	
 }
@@ -17,14 +21,70 @@ UTutCharacterMovementComponent* AMyCustomCharacter::GetCustomCharacterMovement()
 	return GetCharacterMovement<UTutCharacterMovementComponent>();
 }
 
-FCollisionQueryParams AMyCustomCharacter::GetIgnoreCharacterParams() const
+const FCollisionQueryParams& AMyCustomCharacter::GetIgnoreCharacterParams()
 {
-	FCollisionQueryParams Params;
+	if (!bIgnoreCharacterParamsDirty)
+	{
+		INC_DWORD_STAT(STAT_TutIgnoreParamsCacheHits);
+		return CachedIgnoreCharacterParams;
+	}
 
-	TArray<AActor*> CharacterChildren;
-	GetAllChildActors(CharacterChildren);
-	Params.AddIgnoredActors(CharacterChildren);
-	Params.AddIgnoredActor(this);
+	INC_DWORD_STAT(STAT_TutIgnoreParamsRebuilds);
 
-	return Params;
-}
\ No newline at end of file
+	TArray<AActor*> IgnoredActors;
+	GetAllChildActors(IgnoredActors);
+
+	//Weapons and the like attached to a mesh socket. Child actors are attached to their component, so skip those we already have.
+	ForEachAttachedActors([&IgnoredActors](AActor* AttachedActor)
+	{
+		IgnoredActors.AddUnique(AttachedActor);
+		return true;
+	});
+
+	CachedIgnoreCharacterParams = FCollisionQueryParams();
+	for (AActor* IgnoredActor : IgnoredActors)
+	{
+		CachedIgnoreCharacterParams.AddIgnoredActor(IgnoredActor);
+
+		//Child actors are destroyed whenever their component respawns them, and don't attach to anything we are told about.
+		IgnoredActor->OnDestroyed.AddUniqueDynamic(this, &AMyCustomCharacter::OnIgnoredActorDestroyed);
+	}
+	CachedIgnoreCharacterParams.AddIgnoredActor(this);
+
+	bIgnoreCharacterParamsDirty = false;
+	return CachedIgnoreCharacterParams;
+}
+
+void AMyCustomCharacter::InvalidateIgnoreCharacterParams()
+{
+	bIgnoreCharacterParamsDirty = true;
+}
+
+void AMyCustomCharacter::OnIgnoredActorDestroyed(AActor* DestroyedActor)
+{
+	InvalidateIgnoreCharacterParams();
+}
+
+void AMyCustomCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	if (UTutCharacterMovementComponent* Movement = GetCustomCharacterMovement())
+	{
+		Movement->OnControllerChanged();
+	}
+}
+
+float AMyCustomCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	const float Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	//Never lower our own player's priority, they need their corrections.
+	if (!bUseDistanceNetPriority || ViewTarget == this || Viewer == GetController())
+	{
+		return Priority;
+	}
+
+	const float Distance = FVector::Dist(ViewPos, GetActorLocation());
+	return Priority * FMath::GetMappedRangeValueClamped(FVector2f(NetPriorityNearDistance, NetPriorityFarDistance), FVector2f(1.f, FarNetPriorityScale), Distance);
+}
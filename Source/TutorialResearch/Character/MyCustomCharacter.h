@@ -27,7 +27,54 @@ public:
 	UTutCharacterMovementComponent* GetCustomCharacterMovement() const;
 
 	/**
-	 * Helper for gathering ignored actors list. Can be extended.
+	 * Helper for gathering ignored actors list: ourselves, our child actors and every actor attached to us. Can be extended.
+	 * The result is cached until something attaches to or detaches from our capsule or mesh, or one of the ignored actors is destroyed
+	 * (which is also how a respawned child actor gets picked up).
 	 */
-	FCollisionQueryParams GetIgnoreCharacterParams() const;
+	const FCollisionQueryParams& GetIgnoreCharacterParams();
+
+	/**
+	 * Marks the cached ignore params as stale. They are rebuilt the next time they are requested.
+	 * Only needed for changes GetIgnoreCharacterParams isn't told about: attaching to one of our other components,
+	 * giving an empty child actor component a class, or subclasses extending the list.
+	 */
+	UFUNCTION(BlueprintCallable)
+	void InvalidateIgnoreCharacterParams();
+
+	/*
+	* Optional distance-based update policy for simulated proxies.
+	* The server sends replication updates to a connection in order of priority, and an actor's priority keeps growing the longer it waits.
+	* Scaling the priority down with distance from the connection's view means that when a connection runs out of bandwidth, far characters wait
+	* longer between updates while near ones keep updating at full rate. With bandwidth to spare, every character is still sent at NetUpdateFrequency.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Replication")
+	bool bUseDistanceNetPriority = false;
+
+	//Full priority up to this distance from the viewer.
+	UPROPERTY(EditDefaultsOnly, Category = "Replication", meta = (ClampMin = "0.0", EditCondition = "bUseDistanceNetPriority"))
+	float NetPriorityNearDistance = 2000.f;
+
+	//FarNetPriorityScale from this distance on, blended in between.
+	UPROPERTY(EditDefaultsOnly, Category = "Replication", meta = (ClampMin = "0.0", EditCondition = "bUseDistanceNetPriority"))
+	float NetPriorityFarDistance = 10000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Replication", meta = (ClampMin = "0.01", ClampMax = "1.0", EditCondition = "bUseDistanceNetPriority"))
+	float FarNetPriorityScale = 0.25f;
+
+	//Lets the movement component follow a new controller: UTutAIMovementComponent swaps its prediction data, the movement manager its tick order.
+	virtual void NotifyControllerChanged() override;
+
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
+private:
+
+	UFUNCTION()
+	void OnIgnoredActorDestroyed(AActor* DestroyedActor);
+
+	/**
+	 * Movement traces ask for these params several times per physics iteration.
+	 * Rebuilding them means a fresh FCollisionQueryParams and a walk over our components every time, so we keep them until they go stale.
+	 */
+	FCollisionQueryParams CachedIgnoreCharacterParams;
+	bool bIgnoreCharacterParamsDirty = true;
 };
@@ -0,0 +1,119 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutAIMovementComponent.h"
+#include "TutNavArea_WallRun.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationData.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "GameFramework/Character.h"
+
+UTutAIMovementComponent::UTutAIMovementComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	WallRunNavArea = UTutNavArea_WallRun::StaticClass();
+
+	//Server-driven characters are what the movement manager is for.
+	bUseMovementManager = true;
+	//Probes only happen inside the wall run area now, there are too few of them left for the async probe to save anything.
+	bUseAsyncWallProbes = false;
+}
+
+bool UTutAIMovementComponent::NeedsFullPrediction() const
+{
+	return CharacterOwner && CharacterOwner->IsPlayerControlled();
+}
+
+FNetworkPredictionData_Client* UTutAIMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData)
+	{
+		ensureMsgf(!bHasLightweightPredictionData || !NeedsFullPrediction(), TEXT("%s is player-controlled but still has lightweight prediction data. OnControllerChanged wasn't called."), *GetPathNameSafe(this));
+		return ClientPredictionData;
+	}
+
+	if (NeedsFullPrediction())
+	{
+		bHasLightweightPredictionData = false;
+		return Super::GetPredictionData_Client();
+	}
+
+	check(PawnOwner != NULL);
+
+	//Simulated proxies only need this for smoothing, which the engine's version does on its own.
+	UTutAIMovementComponent* MutableThis = const_cast<UTutAIMovementComponent*>(this);
+	MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Character(*this);
+	bHasLightweightPredictionData = true;
+
+	return ClientPredictionData;
+}
+
+void UTutAIMovementComponent::OnControllerChanged()
+{
+	Super::OnControllerChanged();
+
+	//We were a proxy and got possessed by a player, or the other way around.
+	if (ClientPredictionData && bHasLightweightPredictionData == NeedsFullPrediction())
+	{
+		ResetPredictionData_Client();
+		bHasLightweightPredictionData = false;
+	}
+}
+
+SIZE_T UTutAIMovementComponent::GetClientPredictionDataSize() const
+{
+	return bHasLightweightPredictionData ? sizeof(FNetworkPredictionData_Client_Character) : Super::GetClientPredictionDataSize();
+}
+
+const FCustomSavedMovePool::FCounters* UTutAIMovementComponent::GetSavedMovePoolCounters() const
+{
+	return bHasLightweightPredictionData ? nullptr : Super::GetSavedMovePoolCounters();
+}
+
+bool UTutAIMovementComponent::MayProbeForWallRun()
+{
+	//A player-controlled character probes like any other, so client and server agree.
+	return NeedsFullPrediction() || IsOnWallRunNavArea();
+}
+
+bool UTutAIMovementComponent::UsesBaseMovementGates() const
+{
+	return IsOfNativeClass(UTutAIMovementComponent::StaticClass());
+}
+
+bool UTutAIMovementComponent::IsOnWallRunNavArea()
+{
+	const AAIController* AIController = Cast<AAIController>(CharacterOwner->GetController());
+	const UPathFollowingComponent* PathFollowing = AIController ? AIController->GetPathFollowingComponent() : nullptr;
+	const FNavPathSharedPtr Path = PathFollowing ? PathFollowing->GetPath() : nullptr;
+	if (!Path.IsValid() || !Path->IsValid())
+	{
+		CachedPath.Reset();
+		return bProbeWallsWithoutNavPath;
+	}
+
+	//Paths are updated in place when they are recalculated, hence the time stamp.
+	const int32 Segment = PathFollowing->GetCurrentPathIndex();
+	if (CachedPath.HasSameObject(Path.Get()) && CachedPathTimeStamp == Path->GetTimeStamp() && CachedPathSegment == Segment)
+	{
+		return bCachedOnWallRunNavArea;
+	}
+
+	CachedPath = Path;
+	CachedPathTimeStamp = Path->GetTimeStamp();
+	CachedPathSegment = Segment;
+	bCachedOnWallRunNavArea = false;
+
+	/*
+	* Navmesh paths get a point wherever they cross into a different area, and each point carries the area of the poly it starts.
+	* So the area of the segment we are on is the area of its first point.
+	*/
+	const TArray<FNavPathPoint>& Points = Path->GetPathPoints();
+	const ANavigationData* NavData = Path->GetNavigationDataUsed();
+	if (Points.IsValidIndex(Segment) && NavData && WallRunNavArea)
+	{
+		const UClass* AreaClass = NavData->GetAreaClass(FNavMeshNodeFlags(Points[Segment].Flags).Area);
+		bCachedOnWallRunNavArea = AreaClass && AreaClass->IsChildOf(WallRunNavArea);
+	}
+
+	return bCachedOnWallRunNavArea;
+}
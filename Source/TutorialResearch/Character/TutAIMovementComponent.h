@@ -0,0 +1,79 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TutCharacterMovementComponent.h"
+#include "TutAIMovementComponent.generated.h"
+
+class FNavigationPath;
+class UNavArea;
+
+/*
+* The custom movement component for AI characters (see AMyCustomAICharacter).
+*
+* AI characters are moved by the server and never predicted, so most of what the parent adds for owning clients never applies to them.
+* This variant keeps the same movement modes and replication, and trims the rest:
+* - Wall running is only probed while the character's nav path goes through UTutNavArea_WallRun, rather than on every falling tick.
+*   Level designers mark runnable walls, and everywhere else a falling AI character pays for no traces at all.
+* - As a simulated proxy on clients, it only allocates the engine's plain prediction data, which is all smoothing needs.
+*   The parent's version carries our saved move pool, which a proxy never uses.
+* - It is ticked by UTutMovementManagerSubsystem by default.
+*
+* If a player possesses one of these characters, it behaves like the parent again, since its moves are then predicted.
+*/
+UCLASS()
+class TUTORIALRESEARCH_API UTutAIMovementComponent : public UTutCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UTutAIMovementComponent(const FObjectInitializer& ObjectInitializer);
+
+	//Only nav paths through this area (or a child of it) may start a wall run.
+	UPROPERTY(EditDefaultsOnly, Category = "AI Movement")
+	TSubclassOf<UNavArea> WallRunNavArea;
+
+	//Whether to fall back to the parent's probing when the character isn't following a nav path, e.g. when it was launched or is moved by script.
+	UPROPERTY(EditDefaultsOnly, Category = "AI Movement")
+	bool bProbeWallsWithoutNavPath = false;
+
+	//Allocates the plain or the full prediction data, whichever our current controller needs. Never replaces data that already exists.
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	/*
+	* Called by AMyCustomCharacter whenever its controller changes, on the server and the owning client.
+	* Frees our prediction data if it is the wrong kind for the new controller, so the next GetPredictionData_Client allocates the right one.
+	* Doing it here rather than in the getter means saved moves are only ever freed at this one, well defined point, never out from under a caller.
+	*/
+	virtual void OnControllerChanged() override;
+
+	virtual bool MayProbeForWallRun() override;
+
+	//Our MayProbeForWallRun is only asked after the early outs the batch copies, so the batched gates hold for us too. Not for our subclasses.
+	virtual bool UsesBaseMovementGates() const override;
+
+	//Null while we only have the engine's plain prediction data, which has no pool.
+	virtual const FCustomSavedMovePool::FCounters* GetSavedMovePoolCounters() const override;
+
+protected:
+
+	virtual SIZE_T GetClientPredictionDataSize() const override;
+
+	//Whether our current path segment is in WallRunNavArea. Cached until the path or the segment changes.
+	bool IsOnWallRunNavArea();
+
+	//Player-controlled characters predict their moves, and need everything the parent has.
+	bool NeedsFullPrediction() const;
+
+private:
+
+	TWeakPtr<FNavigationPath> CachedPath;
+	double CachedPathTimeStamp = -1.0;
+	int32 CachedPathSegment = INDEX_NONE;
+	bool bCachedOnWallRunNavArea = false;
+
+	//ClientPredictionData is the engine's plain version rather than ours. Set by the getter, hence mutable.
+	mutable bool bHasLightweightPredictionData = false;
+};
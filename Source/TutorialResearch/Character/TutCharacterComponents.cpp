@@ -0,0 +1,36 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutCharacterComponents.h"
+#include "MyCustomCharacter.h"
+
+static void InvalidateOwnerIgnoreParams(const USceneComponent* Component)
+{
+	if (AMyCustomCharacter* Character = Cast<AMyCustomCharacter>(Component->GetOwner()))
+	{
+		Character->InvalidateIgnoreCharacterParams();
+	}
+}
+
+void UTutCapsuleComponent::OnChildAttached(USceneComponent* ChildComponent)
+{
+	Super::OnChildAttached(ChildComponent);
+	InvalidateOwnerIgnoreParams(this);
+}
+
+void UTutCapsuleComponent::OnChildDetached(USceneComponent* ChildComponent)
+{
+	Super::OnChildDetached(ChildComponent);
+	InvalidateOwnerIgnoreParams(this);
+}
+
+void UTutSkeletalMeshComponent::OnChildAttached(USceneComponent* ChildComponent)
+{
+	Super::OnChildAttached(ChildComponent);
+	InvalidateOwnerIgnoreParams(this);
+}
+
+void UTutSkeletalMeshComponent::OnChildDetached(USceneComponent* ChildComponent)
+{
+	Super::OnChildDetached(ChildComponent);
+	InvalidateOwnerIgnoreParams(this);
+}
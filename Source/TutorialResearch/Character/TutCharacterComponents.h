@@ -0,0 +1,34 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "TutCharacterComponents.generated.h"
+
+/*
+* AMyCustomCharacter's capsule and mesh. The engine only tells the parent component when something attaches to it or detaches from it,
+* so these pass that on to the character, which drops its cached ignore params (see AMyCustomCharacter::GetIgnoreCharacterParams).
+*/
+UCLASS(ClassGroup = Custom)
+class TUTORIALRESEARCH_API UTutCapsuleComponent : public UCapsuleComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	virtual void OnChildAttached(USceneComponent* ChildComponent) override;
+	virtual void OnChildDetached(USceneComponent* ChildComponent) override;
+};
+
+UCLASS(ClassGroup = Custom)
+class TUTORIALRESEARCH_API UTutSkeletalMeshComponent : public USkeletalMeshComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	virtual void OnChildAttached(USceneComponent* ChildComponent) override;
+	virtual void OnChildDetached(USceneComponent* ChildComponent) override;
+};
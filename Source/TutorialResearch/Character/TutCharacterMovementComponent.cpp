@@ -10,42 +10,127 @@
 //Let's include our custom character
 #include "MyCustomCharacter.h"
 #include "Components/CapsuleComponent.h"
+#include "TutWallProbe.h"
+#include "TutMovementStats.h"
+#include "TutCorrectionTelemetry.h"
+#include "TutMovementManagerSubsystem.h"
+#include "TutWallRunSurfaceIndex.h"
+#include "Misc/CommandLine.h"
+#include "Misc/App.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
 
 //Network types required for replication (we need this for GetLifetimeReplicatedProps)
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Engine/NetConnection.h"
 #include "UObject/CoreNetTypes.h"
 
+/*
+* The movement mode registry. Each mode registers its handlers once here, and GetMaxSpeed, PhysCustom and the enter/exit calls look them up by mode byte.
+* To add a mode (a slide, say): add MOVE_Sliding to ECustomMovementMode, write its Phys/Enter/Exit functions, then register them below.
+* Leaving MaxSpeed null keeps the walking and sprinting speeds.
+*/
+const UTutCharacterMovementComponent::FCustomModeRegistry UTutCharacterMovementComponent::CustomModes = FCustomModeRegistry()
+	.Register(MOVE_WallRunning, { &ThisClass::PhysWallRun, &ThisClass::GetMaxWallRunSpeed, &ThisClass::EnterWallRun, &ThisClass::ExitWallRun });
+
+//The engine runs the physics of its own modes, so these only add our events.
+const UTutCharacterMovementComponent::FStandardModeRegistry UTutCharacterMovementComponent::StandardModes = FStandardModeRegistry()
+	.Register(MOVE_Flying, { nullptr, nullptr, &ThisClass::EnterFlying, &ThisClass::ExitFlying });
+
+//Simulated proxies get the custom mode through FTutReplicatedMovementState, which only has room for so many.
+static_assert(MOVE_CustomMAX <= (1 << FTutReplicatedMovementState::CustomModeBits), "ECustomMovementMode has outgrown FTutReplicatedMovementState::CustomModeBits.");
+
 UTutCharacterMovementComponent::UTutCharacterMovementComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
-	CustomMaxSpeed = 800.0f;
+	SpeedTiers.Add({ TEXT("Sprint"), 800.f });
+	SpeedTiers.Add({ TEXT("BuffedSprint"), 1000.f });
+	SpeedTiers.Add({ TEXT("Encumbered"), 600.f });
 	SetIsReplicatedByDefault(true);
 
 	//Tells the system to use the new packed data system
 	SetNetworkMoveDataContainer(MoveDataContainer);
+	//And the same for the server's responses
+	SetMoveResponseDataContainer(MoveResponseDataContainer);
 }
 
 void UTutCharacterMovementComponent::BeginPlay()
 {
 	Super::BeginPlay();
 	CustomCharacter = Cast<AMyCustomCharacter>(PawnOwner);
-	
+	WallRunSurfaces = GetWorld()->GetSubsystem<UTutWallRunSurfaceSubsystem>();
+	WallRunGravityScaleLUT = FTutCurveLUT::FindOrBake(WallRunGravityScaleCurve, -1.f, 1.f);
+
+	if (bUseMovementManager && CanUseMovementManager())
+	{
+		if (UTutMovementManagerSubsystem* Manager = GetWorld()->GetSubsystem<UTutMovementManagerSubsystem>())
+		{
+			Manager->Register(this);
+		}
+	}
+}
+
+#if WITH_EDITOR
+void UTutCharacterMovementComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	//Tiers past the limit could never be selected, so don't let them be added in the first place.
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(UTutCharacterMovementComponent, SpeedTiers) && SpeedTiers.Num() > MaxSpeedTiers)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: SpeedTiers can hold at most %d tiers, removing the last %d."), *GetPathNameSafe(this), MaxSpeedTiers, SpeedTiers.Num() - MaxSpeedTiers);
+		SpeedTiers.SetNum(MaxSpeedTiers);
+	}
 }
+#endif
 
 //Sprinting and movement speed changes
 #pragma region Sprinting + Custom Speed
 
 float UTutCharacterMovementComponent::GetMaxSpeed() const
 {
-	if (MovementMode == MOVE_Custom) {
+	if (const FModeHandlers::FMaxSpeedFunction MaxSpeed = FindModeHandlers(MovementMode, CustomMovementMode).MaxSpeed)
+	{
+		return (this->*MaxSpeed)();
+	}
 
-		switch (CustomMovementMode)
-		{
-		case MOVE_WallRunning:
-			return MaxWallRunSpeed;
-		}
+	return bIsSprinting ? GetCustomMaxSpeed() : Super::GetMaxSpeed();
+}
+
+float UTutCharacterMovementComponent::GetCustomMaxSpeed() const
+{
+	const uint8 SpeedTier = GetSpeedTier();
+	if (SpeedTiers.IsValidIndex(SpeedTier))
+	{
+		return SpeedTiers[SpeedTier].MaxSpeed;
+	}
+	return SpeedTiers.Num() > 0 ? SpeedTiers[0].MaxSpeed : Super::GetMaxSpeed();
+}
+
+void UTutCharacterMovementComponent::SetSpeedTier(uint8 NewSpeedTier)
+{
+	if (!ensureMsgf(NewSpeedTier < MaxSpeedTiers, TEXT("%s: speed tier %d doesn't fit in the movement flags, only %d tiers are supported."), *GetPathNameSafe(this), NewSpeedTier, MaxSpeedTiers))
+	{
+		return;
+	}
+
+	MovementFlagCustom = (MovementFlagCustom & ~SpeedTierMask) | ((NewSpeedTier << SpeedTierShift) & SpeedTierMask);
+}
+
+bool UTutCharacterMovementComponent::SetSpeedTierByName(FName SpeedTierName)
+{
+	const int32 SpeedTier = SpeedTiers.IndexOfByPredicate([SpeedTierName](const FCustomSpeedTier& Tier) { return Tier.Name == SpeedTierName; });
+	if (SpeedTier == INDEX_NONE)
+	{
+		return false;
+	}
+	if (!ensureMsgf(SpeedTier < MaxSpeedTiers, TEXT("%s: speed tier %s is at index %d, past the %d tiers the movement flags can hold."), *GetPathNameSafe(this), *SpeedTierName.ToString(), SpeedTier, MaxSpeedTiers))
+	{
+		return false;
 	}
 
-	return bIsSprinting ? CustomMaxSpeed : Super::GetMaxSpeed();
+	SetSpeedTier((uint8)SpeedTier);
+	return true;
 }
 
 /*
@@ -54,6 +139,8 @@ float UTutCharacterMovementComponent::GetMaxSpeed() const
 */
 bool UTutCharacterMovementComponent::CanSprint() const
 {
+	TUT_MOVEMENT_SCOPE(CanSprint);
+
 	if (CustomCharacter && IsMovingOnGround() && bWantsToSprint) //Only sprint if on ground 
 	{
 		//Check if moving forward
@@ -61,7 +148,7 @@ bool UTutCharacterMovementComponent::CanSprint() const
 		FVector MoveDirection = Velocity.GetSafeNormal();
 
 		float VelocityDot = FVector::DotProduct(Forward, MoveDirection); //Confirm we are moving forward so the player can't sprint sideways or backwards.
-		return VelocityDot > 0.7f; //Slight lenience so that small changes don't rapidly toggle sprinting. This should be a variable, but it is hard-coded here for simplicity.
+		return VelocityDot > SprintForwardDot; //Slight lenience so that small changes don't rapidly toggle sprinting.
 	}
 	return false;
 }
@@ -91,8 +178,9 @@ void UTutCharacterMovementComponent::LaunchCharacterReplicated(FVector NewLaunch
 		FinalVel.Z += Velocity.Z;
 	}
 
-	LaunchVelocityCustom = FinalVel;
-	
+	//When quantization is on, predict with exactly the value the server will decode.
+	LaunchVelocityCustom = MoveDataQuantization.bQuantizeMoveData ? MoveDataQuantization.RoundLaunchVelocity(FinalVel) : FinalVel;
+
 	//This isn't where the launch occurs, it is a blueprint implementable event for additional BP logic. See the declaration for more info.
 	//The launch will occur next frame in this setup when PendingLaunchVelocity is handled by HandlePendingLaunch() during the PerformMovement() update.
 	//If you need special logic, you can always override HandlePendingLaunch(), which we have already done. 
@@ -121,6 +209,7 @@ bool UTutCharacterMovementComponent::HandlePendingLaunch()
 		Velocity = PendingLaunchVelocity;
 		SetMovementMode(MOVE_Falling); //Notice that we enter falling after launch in the base version, which may not be what you want. 
 		PendingLaunchVelocity = FVector::ZeroVector;
+		LastLaunchTime = GetWorld()->GetTimeSeconds();
 		bForceNextFloorCheck = true;
 		return true;
 	}
@@ -150,9 +239,9 @@ bool UTutCharacterMovementComponent::DoJump(bool bReplayingMoves)
 			FVector Start = UpdatedComponent->GetComponentLocation();
 			FVector CastDelta = UpdatedComponent->GetRightVector() * OwnerCapsuleRadius() * 2;
 			FVector End = bWallRunIsRight ? Start + CastDelta : Start - CastDelta;
-			auto Params = CustomCharacter->GetIgnoreCharacterParams();
+			const FCollisionQueryParams& Params = CustomCharacter->GetIgnoreCharacterParams();
 			FHitResult WallHit;
-			GetWorld()->LineTraceSingleByProfile(WallHit, Start, End, "BlockAll", Params);
+			FTutWallProbe::Trace(GetWorld(), WallHit, Start, End, Params);
 			Velocity += WallHit.Normal * WallJumpForce;
 		}
 		return true;
@@ -170,25 +259,61 @@ bool UTutCharacterMovementComponent::IsCustomMovementMode(uint8 TestCustomMoveme
 
 void UTutCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
 {
+	TUT_MOVEMENT_SCOPE(PhysCustom);
+
 	// Phys* functions should only run for characters with ROLE_Authority or ROLE_AutonomousProxy. However, Unreal calls PhysCustom in
 	// two separate locations, one of which doesn't check the role, so we must check it here to prevent this code from running on simulated proxies.
 	if (GetOwner()->GetLocalRole() == ROLE_SimulatedProxy)
 		return;
 
-	switch (CustomMovementMode)
+	if (const FModeHandlers::FPhysFunction Phys = CustomModes.Find(CustomMovementMode).Phys)
 	{
-	case MOVE_WallRunning:
-	{
-		PhysWallRun(deltaTime, Iterations);
-		break;
+		(this->*Phys)(deltaTime, Iterations);
 	}
-	default:
-		UE_LOG(LogTemp, Fatal, TEXT("Invalid Movement Mode"))
+	else
+	{
+		//A mode without physics would leave the character stuck in place forever. Fall back to the default mode instead of crashing.
+		ensureMsgf(false, TEXT("Custom movement mode %d has no Phys function registered."), CustomMovementMode);
+		SetDefaultMovementMode();
 	}
 
 	Super::PhysCustom(deltaTime, Iterations);
 }
 
+/*
+* Nothing changes about how physics runs here. We only wrap each mode in its own cycle stat and Insights event,
+* so "stat TutMovement" and Unreal Insights can show where the time goes instead of one "CharacterMovement" block.
+*/
+void UTutCharacterMovementComponent::StartNewPhysics(float deltaTime, int32 Iterations)
+{
+	TStatId ModeStatId = GET_STATID(STAT_TutModeOther);
+	const TCHAR* ModeName = TEXT("TutMode_Other");
+	switch (MovementMode)
+	{
+	case MOVE_Walking:
+	case MOVE_NavWalking:	ModeStatId = GET_STATID(STAT_TutModeWalking);	ModeName = TEXT("TutMode_Walking");		break;
+	case MOVE_Falling:		ModeStatId = GET_STATID(STAT_TutModeFalling);	ModeName = TEXT("TutMode_Falling");		break;
+	case MOVE_Flying:		ModeStatId = GET_STATID(STAT_TutModeFlying);	ModeName = TEXT("TutMode_Flying");		break;
+	case MOVE_Swimming:		ModeStatId = GET_STATID(STAT_TutModeSwimming);	ModeName = TEXT("TutMode_Swimming");	break;
+	case MOVE_Custom:
+		if (CustomMovementMode == MOVE_WallRunning)
+		{
+			ModeStatId = GET_STATID(STAT_TutModeWallRunning);
+			ModeName = TEXT("TutMode_WallRunning");
+		}
+		break;
+	default: break;
+	}
+
+#if STATS
+	FScopeCycleCounter ModeCycleCounter(ModeStatId);
+#endif
+	//The mode isn't known until runtime, so Insights gets a dynamic event name. It costs a name lookup, but only while the channel is enabled.
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(ModeName, TutMovementChannel);
+
+	Super::StartNewPhysics(deltaTime, Iterations);
+}
+
 #pragma region Flying
 
 //Whether or not we should allow the player to fly in a certain situation.
@@ -217,41 +342,69 @@ void UTutCharacterMovementComponent::ExitFlying_Implementation()
 // Edits have been made for our custom character.
 bool UTutCharacterMovementComponent::TryWallRun()
 {
+	TUT_MOVEMENT_SCOPE(TryWallRun);
+
 	if (!IsFalling()) return false;
 	if (Velocity.SizeSquared2D() < pow(MinWallRunSpeed, 2)) return false;
 	if (Velocity.Z < -MaxVerticalWallRunSpeed) return false;
+	//We recently probed and found nothing. Don't pay for the traces again until the cooldown runs out.
+	if (WallRunProbeCooldownRemaining > 0.f) return false;
 	if (!CustomCharacter) return false;
+	if (!MayProbeForWallRun()) return false;
 
-	FVector Start = UpdatedComponent->GetComponentLocation();
-	FVector LeftEnd = Start - UpdatedComponent->GetRightVector() * OwnerCapsuleRadius() * 2;
-	FVector RightEnd = Start + UpdatedComponent->GetRightVector() * OwnerCapsuleRadius() * 2;
-	auto Params = CustomCharacter->GetIgnoreCharacterParams();
-	FHitResult FloorHit, WallHit;
-	// Check Player Height
-	if (GetWorld()->LineTraceSingleByProfile(FloorHit, Start, Start + FVector::DownVector * (OwnerCapsuleHalfHeight() + MinWallRunHeight), "BlockAll", Params))
+	const FTutWallProbeQuery Query = MakeWallProbeQuery();
+
+	/*
+	* Nothing to run along within reach, according to the level's baked index. The side traces can't find a wall, but the floor trace still decides
+	* what happens next, like it does for a full probe: floor too close means no cooldown (we are about to land), anything else is a probe that found no wall.
+	*/
+	if (IsWallRunRuledOutBySurfaceIndex(Query))
 	{
+		FHitResult FloorHit;
+		if (!FTutWallProbe::Trace(GetWorld(), FloorHit, Query.Start, Query.Start + FVector::DownVector * Query.FloorDistance, CustomCharacter->GetIgnoreCharacterParams()))
+		{
+			WallRunProbeCooldownRemaining = WallRunProbeCooldown;
+		}
 		return false;
 	}
 
-	// Left Cast
-	GetWorld()->LineTraceSingleByProfile(WallHit, Start, LeftEnd, "BlockAll", Params);
-	if (WallHit.IsValidBlockingHit() && (Velocity | WallHit.Normal) < 0)
+	FTutWallProbeResult Probe;
+
+	//The movement manager may already have probed from exactly here on a worker thread. If anything moved us since, the query won't match.
+	if (bHasPrecomputedWallProbe && PrecomputedWallProbeQuery == Query)
 	{
-		bWallRunIsRight = false;
+		Probe = PrecomputedWallProbe;
 	}
-	// Right Cast
 	else
 	{
-		GetWorld()->LineTraceSingleByProfile(WallHit, Start, RightEnd, "BlockAll", Params);
-		if (WallHit.IsValidBlockingHit() && (Velocity | WallHit.Normal) < 0)
-		{
-			bWallRunIsRight = true;
-		}
-		else
+		if (CanUseAsyncWallProbe())
 		{
-			return false;
+			//Ask for next frame's result before we possibly bail out, so there is always one in flight while we are falling.
+			const bool bRuledOut = AsyncWallProbe.RulesOutWallRun(GetWorld(), Query);
+			AsyncWallProbe.Request(GetWorld(), Query, GetWorld()->GetDeltaSeconds(), AsyncWallProbeMargin, CustomCharacter->GetIgnoreCharacterParams());
+			if (bRuledOut)
+			{
+				//Exactly what the synchronous path does when it finds no wall.
+				WallRunProbeCooldownRemaining = WallRunProbeCooldown;
+				return false;
+			}
 		}
+
+		FTutWallProbe::ProbeForWallRun(GetWorld(), Query, CustomCharacter->GetIgnoreCharacterParams(), Probe);
+	}
+
+	if (Probe.bFloorTooClose)
+	{
+		return false;
+	}
+	if (!Probe.HasWall())
+	{
+		WallRunProbeCooldownRemaining = WallRunProbeCooldown;
+		return false;
 	}
+
+	bWallRunIsRight = Probe.bWallIsRight;
+	const FHitResult& WallHit = Probe.WallHit;
 	FVector ProjectedVelocity = FVector::VectorPlaneProject(Velocity, WallHit.Normal);
 	if (ProjectedVelocity.SizeSquared2D() < pow(MinWallRunSpeed, 2)) return false;
 
@@ -262,6 +415,49 @@ bool UTutCharacterMovementComponent::TryWallRun()
 		return true;
 }
 
+FTutWallProbeQuery UTutCharacterMovementComponent::MakeWallProbeQuery() const
+{
+	FTutWallProbeQuery Query;
+	Query.Start = UpdatedComponent->GetComponentLocation();
+	Query.RightVector = UpdatedComponent->GetRightVector();
+	Query.SideDistance = OwnerCapsuleRadius() * 2;
+	Query.FloorDistance = OwnerCapsuleHalfHeight() + MinWallRunHeight;
+	Query.Velocity = Velocity;
+	return Query;
+}
+
+bool UTutCharacterMovementComponent::IsWallRunRuledOutBySurfaceIndex(const FTutWallProbeQuery& Query) const
+{
+	const UTutWallRunSurfaceIndex* SurfaceIndex = WallRunSurfaces ? WallRunSurfaces->GetIndex() : nullptr;
+	if (!SurfaceIndex || !CustomCharacter)
+	{
+		return false;
+	}
+
+	TUT_MOVEMENT_SCOPE(SurfaceIndexQuery);
+
+	//The side traces only ever reach SideDistance from Start, so a wall further away than that can't be hit.
+	if (SurfaceIndex->HasSurfaceNear(Query.Start, Query.SideDistance))
+	{
+		return false;
+	}
+
+	//Movable and runtime-spawned collision isn't baked, and neither are other characters. Near any of it, trace as if there were no index.
+	if (WallRunSurfaces->HasUnindexedPrimitiveNear(Query.Start, Query.SideDistance, CustomCharacter->GetIgnoreCharacterParams()))
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_TutWallProbesSkippedBySurfaceIndex);
+	return true;
+}
+
+bool UTutCharacterMovementComponent::CanUseAsyncWallProbe() const
+{
+	//Replayed moves must give the same answer as the original move, which means the synchronous probes.
+	return bUseAsyncWallProbes && CharacterOwner->HasAuthority() && !IsNetMode(NM_Client) && !CharacterOwner->bClientUpdating;
+}
+
 /*
 * This code shows how a C++ custom movement mode should be written in respect to an existing pattern within the parent CMC. 
 * Be sure to take a look at the structure of each of the Phys functions for physwalking, physflying, etc to see this pattern.
@@ -274,6 +470,8 @@ bool UTutCharacterMovementComponent::TryWallRun()
 */
 void UTutCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iterations)
 {
+	TUT_MOVEMENT_SCOPE(PhysWallRun);
+
 	if (deltaTime < MIN_TICK_TIME)
 	{
 		return;
@@ -287,6 +485,7 @@ void UTutCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iteratio
 
 	bJustTeleported = false;
 	float remainingTime = deltaTime;
+	float LastTimeTick = 0.f;
 	// Perform the move
 	while ((remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)))
 	{
@@ -294,15 +493,16 @@ void UTutCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iteratio
 		bJustTeleported = false;
 		const float timeTick = GetSimulationTimeStep(remainingTime, Iterations);
 		remainingTime -= timeTick;
+		LastTimeTick = timeTick;
 		const FVector OldLocation = UpdatedComponent->GetComponentLocation();
 
 		FVector Start = UpdatedComponent->GetComponentLocation();
 		FVector CastDelta = UpdatedComponent->GetRightVector() * OwnerCapsuleRadius() * 2;
 		FVector End = bWallRunIsRight ? Start + CastDelta : Start - CastDelta;
-		auto Params = CustomCharacter->GetIgnoreCharacterParams();
+		const FCollisionQueryParams& Params = CustomCharacter->GetIgnoreCharacterParams();
 		float SinPullAwayAngle = FMath::Sin(FMath::DegreesToRadians(WallRunPullAwayAngle));
 		FHitResult WallHit;
-		GetWorld()->LineTraceSingleByProfile(WallHit, Start, End, "BlockAll", Params);
+		WallContactCache.TraceWall(GetWorld(), WallHit, Start, End, Params, GetWallContactCacheThreshold(timeTick));
 		bool bWantsToPullAway = WallHit.IsValidBlockingHit() && !Acceleration.IsNearlyZero() && (Acceleration.GetSafeNormal() | WallHit.Normal) > SinPullAwayAngle;
 		if (!WallHit.IsValidBlockingHit() || bWantsToPullAway)
 		{
@@ -318,7 +518,7 @@ void UTutCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iteratio
 		Velocity = FVector::VectorPlaneProject(Velocity, WallHit.Normal);
 		float TangentAccel = Acceleration.GetSafeNormal() | Velocity.GetSafeNormal2D();
 		bool bVelUp = Velocity.Z > 0.f;
-		Velocity.Z += GetGravityZ() * (WallRunGravityScaleCurve ? WallRunGravityScaleCurve->GetFloatValue(bVelUp ? 0.f : TangentAccel) * timeTick : 0.0f);
+		Velocity.Z += GetGravityZ() * GetWallRunGravityScale(bVelUp ? 0.f : TangentAccel) * timeTick;
 		if (Velocity.SizeSquared2D() < pow(MinWallRunSpeed, 2) || Velocity.Z < -MaxVerticalWallRunSpeed)
 		{
 			SetMovementMode(MOVE_Falling);
@@ -352,16 +552,38 @@ void UTutCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iteratio
 	FVector Start = UpdatedComponent->GetComponentLocation();
 	FVector CastDelta = UpdatedComponent->GetRightVector() * OwnerCapsuleRadius() * 2;
 	FVector End = bWallRunIsRight ? Start + CastDelta : Start - CastDelta;
-	auto Params = CustomCharacter->GetIgnoreCharacterParams();
+	const FCollisionQueryParams& Params = CustomCharacter->GetIgnoreCharacterParams();
 	FHitResult FloorHit, WallHit;
-	GetWorld()->LineTraceSingleByProfile(WallHit, Start, End, "BlockAll", Params);
-	GetWorld()->LineTraceSingleByProfile(FloorHit, Start, Start + FVector::DownVector * (OwnerCapsuleHalfHeight() + MinWallRunHeight * .5f), "BlockAll", Params);
+	WallContactCache.TraceWall(GetWorld(), WallHit, Start, End, Params, GetWallContactCacheThreshold(LastTimeTick));
+	FTutWallProbe::Trace(GetWorld(), FloorHit, Start, Start + FVector::DownVector * (OwnerCapsuleHalfHeight() + MinWallRunHeight * .5f), Params);
 	if (FloorHit.IsValidBlockingHit() || !WallHit.IsValidBlockingHit() || Velocity.SizeSquared2D() < pow(MinWallRunSpeed, 2))
 	{
 		SetMovementMode(MOVE_Falling);
 	}
 }
 
+float UTutCharacterMovementComponent::GetWallContactCacheThreshold(float TimeStep) const
+{
+	//Replayed moves start from where the server put us, so nothing a move before the correction traced can be trusted. See also ClientHandleMoveResponse.
+	if (WallContactCacheSteps <= 0.f || (CharacterOwner && CharacterOwner->bClientUpdating))
+	{
+		return 0.f;
+	}
+
+	//A fixed distance either never hits at sprint speed or reuses hits for far too long at a walk, so go by how far a sub-step takes us.
+	return FMath::Max(WallContactCacheThreshold, Velocity.Size() * TimeStep * WallContactCacheSteps);
+}
+
+float UTutCharacterMovementComponent::GetWallRunGravityScale(float TangentAccel) const
+{
+	//The curve may have been swapped since BeginPlay, in which case the table is stale.
+	if (WallRunGravityScaleLUT && WallRunGravityScaleLUT->GetSource() == WallRunGravityScaleCurve)
+	{
+		return WallRunGravityScaleLUT->Evaluate(TangentAccel);
+	}
+	return WallRunGravityScaleCurve ? WallRunGravityScaleCurve->GetFloatValue(TangentAccel) : 0.f;
+}
+
 //Code to execute upon entering wall running
 void UTutCharacterMovementComponent::EnterWallRun_Implementation()
 {
@@ -428,42 +650,31 @@ void UTutCharacterMovementComponent::OnMovementModeChanged(EMovementMode Previou
 	* This design pattern is handy for many systems, as mentioned, but movement is one such place where it can be essential. 
 	*/
 	
-	//First, call exit code for the PREVIOUS movement mode.
-	if (PreviousMovementMode == MOVE_Custom) 
-	{
+	LastModeChangeTime = GetWorld()->GetTimeSeconds();
 
-		switch (PreviousCustomMode)
-		{
-		case MOVE_WallRunning:
-			ExitWallRun();
-		}
-	}
-	else 
+	//The wall we cached belongs to the previous wall run. Done here rather than in Enter/ExitWallRun as those can be overridden in BP.
+	if (IsWallRunning() || (PreviousMovementMode == MOVE_Custom && PreviousCustomMode == MOVE_WallRunning))
 	{
-		switch (PreviousMovementMode)
-		{
-		case MOVE_Flying:
-			ExitFlying();
-		}
+		WallContactCache.Reset();
 	}
 
-	//Next, call entry code for the NEW movement mode.
-	if (MovementMode == MOVE_Custom) 
+	//A frozen proxy isn't being looked at closely. Its enter and exit events wait until it unfreezes, see SetProxyLOD.
+	if (ProxyLOD == ETutProxyLOD::Frozen)
 	{
-
-		switch (CustomMovementMode)
+		if (!bModeEventsDeferred)
 		{
-		case MOVE_WallRunning:
-			EnterWallRun();
+			bModeEventsDeferred = true;
+			DeferredEventMode = PreviousMovementMode;
+			DeferredEventCustomMode = PreviousCustomMode;
 		}
 	}
 	else
 	{
-		switch (MovementMode)
-		{
-		case MOVE_Flying:
-			EnterFlying();
-		}
+		//First, call exit code for the PREVIOUS movement mode.
+		CallMovementModeExit(PreviousMovementMode, PreviousCustomMode);
+
+		//Next, call entry code for the NEW movement mode.
+		CallMovementModeEnter(MovementMode, CustomMovementMode);
 	}
 
 
@@ -483,11 +694,19 @@ void UTutCharacterMovementComponent::OnMovementModeChanged(EMovementMode Previou
 void UTutCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
 {
 	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	//The movement manager's gates are only good for the move it ticked us for.
+	const bool bUseBatchedGates = bHasBatchedGates;
+	bHasBatchedGates = false;
+
 	// Proxies get replicated state. We don't need to run this logic for them.
 	if (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
 	{
+		//This is simulated time, not world time, so it stays in sync between the client, the server and replayed moves.
+		WallRunProbeCooldownRemaining = FMath::Max(WallRunProbeCooldownRemaining - DeltaSeconds, 0.f);
+
 		//Sprinting
-		if (CanSprint())
+		if (bUseBatchedGates ? (BatchedGates & BatchedGateSprint) != 0 : CanSprint())
 		{
 			bIsSprinting = true;
 		}
@@ -497,11 +716,14 @@ void UTutCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float De
 		}
 
 		// Wall Run
-		if (IsFalling())
+		if (IsFalling() && (!bUseBatchedGates || (BatchedGates & BatchedGateWallRun) != 0))
 		{
 			TryWallRun();
 		}
 	}
+
+	//Like the gates, a precomputed probe is only good for this move.
+	bHasPrecomputedWallProbe = false;
 }
 
 /*
@@ -549,6 +771,27 @@ void UTutCharacterMovementComponent::OnMovementUpdated(float DeltaSeconds, const
 		PendingLaunchVelocity = LaunchVelocityCustom;
 		LaunchVelocityCustom = FVector(0.f, 0.f, 0.f);
 	}
+
+	if (CharacterOwner->HasAuthority())
+	{
+		UpdateReplicatedMovementState();
+	}
+}
+
+void UTutCharacterMovementComponent::CallMovementModeExit(EMovementMode Mode, uint8 CustomMode)
+{
+	if (const FModeHandlers::FEventFunction Exit = FindModeHandlers(Mode, CustomMode).Exit)
+	{
+		(this->*Exit)();
+	}
+}
+
+void UTutCharacterMovementComponent::CallMovementModeEnter(EMovementMode Mode, uint8 CustomMode)
+{
+	if (const FModeHandlers::FEventFunction Enter = FindModeHandlers(Mode, CustomMode).Enter)
+	{
+		(this->*Enter)();
+	}
 }
 
 #pragma endregion
@@ -574,13 +817,53 @@ void UTutCharacterMovementComponent::GetLifetimeReplicatedProps(TArray< FLifetim
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME_CONDITION(ThisClass, bIsSprinting, COND_SimulatedOnly);
-	DOREPLIFETIME_CONDITION(ThisClass, bWallRunIsRight, COND_SimulatedOnly);
+	/*
+	* The owning client predicts all of this itself, and corrections carry it too. Only simulated proxies need it.
+	* It is push based: the server only compares it after UpdateReplicatedMovementState marks it dirty, instead of on every net update.
+	* Any custom replicated movement state added later should follow the same pattern.
+	*/
+	FDoRepLifetimeParams Params;
+	Params.Condition = COND_SimulatedOnly;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ReplicatedMovementState, Params);
 }
 
 
 //On Reps allow us to perform logic upon receiving a server update.
 //Keep your on reps close to LifetimeRepProps in their own replication section, like this, so they can easily be tracked.
+void UTutCharacterMovementComponent::OnRep_ReplicatedMovementState()
+{
+	bIsSprinting = ReplicatedMovementState.IsSprinting();
+	bWallRunIsRight = ReplicatedMovementState.IsWallRunRight();
+	//Normally set by Enter/ExitFlying when the movement mode replicates. Those wait while a proxy is frozen, this doesn't.
+	bIsFlying = ReplicatedMovementState.IsFlying();
+}
+
+void UTutCharacterMovementComponent::UpdateReplicatedMovementState()
+{
+	const FTutReplicatedMovementState NewState(bIsSprinting, bWallRunIsRight, bIsFlying, MovementMode == MOVE_Custom ? CustomMovementMode : MOVE_CustomNone);
+	if (NewState != ReplicatedMovementState)
+	{
+		ReplicatedMovementState = NewState;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ReplicatedMovementState, this);
+	}
+}
+
+FTutReplicatedMovementState::FTutReplicatedMovementState(bool bIsSprinting, bool bWallRunIsRight, bool bIsFlying, uint8 CustomMovementMode)
+{
+	ensureMsgf(CustomMovementMode < (1 << CustomModeBits), TEXT("Custom movement mode %d doesn't fit in FTutReplicatedMovementState."), CustomMovementMode);
+	Packed = (bIsSprinting ? SprintingBit : 0)
+		| (bWallRunIsRight ? WallRunRightBit : 0)
+		| (bIsFlying ? FlyingBit : 0)
+		| uint8((CustomMovementMode & ((1 << CustomModeBits) - 1)) << CustomModeShift);
+}
+
+bool FTutReplicatedMovementState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar.SerializeBits(&Packed, NumBits);
+	bOutSuccess = true;
+	return true;
+}
 
 
 #pragma endregion
@@ -601,6 +884,8 @@ To extend the server response to clients, which can acknowledges a good move or
 //Receives moves from Serialize
 void UTutCharacterMovementComponent::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
 {
+	TUT_MOVEMENT_SCOPE(MoveAutonomous);
+
 	FCustomNetworkMoveData* CurrentMoveData = static_cast<FCustomNetworkMoveData*>(GetCurrentNetworkMoveData());
 	if (CurrentMoveData != nullptr)
 	{
@@ -611,29 +896,106 @@ void UTutCharacterMovementComponent::MoveAutonomous(float ClientTimeStamp, float
 		//EXAMPLE:
 		//bWantsToFly = (CurrentMoveData->MovementFlagCustomMoveData & (uint8)EMovementFlag::CFLAG_WantsToFly) != 0;
 
-		CustomMaxSpeed = CurrentMoveData->MaxCustomSpeedMoveData;
 		LaunchVelocityCustom = CurrentMoveData->LaunchVelocityCustomMoveData;
 
+		//The speed tier arrives packed inside our flags. We never trust a speed from the client, only an index into our own SpeedTiers table.
+		//An index outside the table is cleared back to tier 0. GetCustomMaxSpeed falls back to the same tier on the client, so this can't cause a correction.
 		MovementFlagCustom = CurrentMoveData->MovementFlagCustomMoveData;
+		if (!SpeedTiers.IsValidIndex(GetSpeedTier()))
+		{
+			SetSpeedTier(0);
+		}
 	}
 	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
 }
 
-//Sends the Movement Data 
+//Sends the Movement Data
 bool FCustomNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
 {
+	TUT_MOVEMENT_SCOPE(SerializeMoveData);
+
 	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
 
-	SerializeOptionalValue<bool>(Ar.IsSaving(), Ar, bWantsToSprintMoveData, false);
-	SerializeOptionalValue<float>(Ar.IsSaving(), Ar, MaxCustomSpeedMoveData, 800.f);
-	SerializeOptionalValue<FVector>(Ar.IsSaving(), Ar, LaunchVelocityCustomMoveData, FVector(0.f, 0.f, 0.f));
+	const UTutCharacterMovementComponent* TutMovement = Cast<UTutCharacterMovementComponent>(&CharacterMovement);
+	if (TutMovement && TutMovement->MoveDataQuantization.bQuantizeMoveData)
+	{
+		SerializeQuantized(TutMovement->MoveDataQuantization, Ar);
+		return !Ar.IsError();
+	}
+
+	//Without a delta baseline these are the same defaults as a default constructed move: false, zero vector and 0.
+	const FCustomNetworkMoveData& Baseline = GetDeltaBaseline();
+
+	SerializeOptionalValue<bool>(Ar.IsSaving(), Ar, bWantsToSprintMoveData, Baseline.bWantsToSprintMoveData);
+	SerializeOptionalValue<FVector>(Ar.IsSaving(), Ar, LaunchVelocityCustomMoveData, Baseline.LaunchVelocityCustomMoveData);
 
-	SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, MovementFlagCustomMoveData, 0);
+	SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, MovementFlagCustomMoveData, Baseline.MovementFlagCustomMoveData);
 
 
 	return !Ar.IsError();
 }
 
+/*
+* Cost per move when a field differs from its default:
+* Full precision: LaunchVelocity = 1 + 192 bits.
+* Quantized (default settings): LaunchVelocity = 1 + 48 bits.
+* The sprint bool is written as a single raw bit as there is nothing to gain from an optional bit in front of it.
+*/
+void FCustomNetworkMoveData::SerializeQuantized(const FCustomMoveDataQuantization& Quantization, FArchive& Ar)
+{
+	const bool bIsSaving = Ar.IsSaving();
+	const FCustomNetworkMoveData& Baseline = GetDeltaBaseline();
+
+	Ar.SerializeBits(&bWantsToSprintMoveData, 1);
+
+	bool bLaunchChanged = bIsSaving && Quantization.RoundLaunchVelocity(LaunchVelocityCustomMoveData) != Quantization.RoundLaunchVelocity(Baseline.LaunchVelocityCustomMoveData);
+	Ar.SerializeBits(&bLaunchChanged, 1);
+	if (bLaunchChanged)
+	{
+		const uint32 MaxValue = 1u << Quantization.LaunchVelocityBitsPerComponent;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			uint32 Component = bIsSaving ? Quantization.QuantizeLaunchComponent(LaunchVelocityCustomMoveData[Axis]) : 0;
+			Ar.SerializeInt(Component, MaxValue);
+			LaunchVelocityCustomMoveData[Axis] = Quantization.DequantizeLaunchComponent(Component);
+		}
+	}
+	else if (!bIsSaving)
+	{
+		LaunchVelocityCustomMoveData = Quantization.RoundLaunchVelocity(Baseline.LaunchVelocityCustomMoveData);
+	}
+
+	SerializeOptionalValue<uint8>(bIsSaving, Ar, MovementFlagCustomMoveData, Baseline.MovementFlagCustomMoveData);
+}
+
+const FCustomNetworkMoveData& FCustomNetworkMoveData::GetDeltaBaseline() const
+{
+	static const FCustomNetworkMoveData DefaultMoveData;
+	return DeltaBaseline ? *DeltaBaseline : DefaultMoveData;
+}
+
+//Launch components are symmetric around zero. We use an odd number of steps so zero stays exactly representable.
+uint32 FCustomMoveDataQuantization::QuantizeLaunchComponent(float Value) const
+{
+	const int32 HalfSteps = (1 << (LaunchVelocityBitsPerComponent - 1)) - 1;
+	const float Normalized = FMath::Clamp(Value / MaxLaunchVelocity, -1.f, 1.f);
+	return (uint32)(FMath::RoundToInt(Normalized * HalfSteps) + HalfSteps);
+}
+
+float FCustomMoveDataQuantization::DequantizeLaunchComponent(uint32 QuantizedValue) const
+{
+	const int32 HalfSteps = (1 << (LaunchVelocityBitsPerComponent - 1)) - 1;
+	return ((int32)QuantizedValue - HalfSteps) * (MaxLaunchVelocity / HalfSteps);
+}
+
+FVector FCustomMoveDataQuantization::RoundLaunchVelocity(const FVector& LaunchVelocity) const
+{
+	return FVector(
+		DequantizeLaunchComponent(QuantizeLaunchComponent(LaunchVelocity.X)),
+		DequantizeLaunchComponent(QuantizeLaunchComponent(LaunchVelocity.Y)),
+		DequantizeLaunchComponent(QuantizeLaunchComponent(LaunchVelocity.Z)));
+}
+
 void FCustomNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
 {
 	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
@@ -641,8 +1003,8 @@ void FCustomNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Characte
 	const FCustomSavedMove& CurrentSavedMove = static_cast<const FCustomSavedMove&>(ClientMove);
 
 	bWantsToSprintMoveData = CurrentSavedMove.bWantsToSprintSaved;
-	MaxCustomSpeedMoveData = CurrentSavedMove.SavedMaxCustomSpeed;
 	LaunchVelocityCustomMoveData = CurrentSavedMove.SavedLaunchVelocityCustom;
+	MoveId = CurrentSavedMove.MoveId;
 
 	MovementFlagCustomMoveData = CurrentSavedMove.SavedMovementFlagCustom;
 }
@@ -650,35 +1012,92 @@ void FCustomNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Characte
 //Combines Flags together as an optimization option by the engine to send less data over the network
 bool FCustomSavedMove::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const
 {
-	FCustomSavedMove* NewMovePtr = static_cast<FCustomSavedMove*>(NewMove.Get());
+	TUT_MOVEMENT_SCOPE(CanCombineWith);
+
+	const FCustomSavedMove* NewMovePtr = static_cast<FCustomSavedMove*>(NewMove.Get());
+
+	const bool bCanCombine = CanCombineCustomState(*NewMovePtr) && Super::CanCombineWith(NewMove, Character, MaxDelta);
 
-	if(bWantsToSprintSaved != NewMovePtr->bWantsToSprintSaved)
+#if STATS
+	//Counted against the mode this (the pending) move ended in, which is the mode the combined move would be in.
+	TEnumAsByte<EMovementMode> Mode;
+	TEnumAsByte<EMovementMode> GroundMode;
+	uint8 CustomMode = 0;
+	Character->GetCharacterMovement()->UnpackNetworkMovementMode(EndPackedMovementMode, Mode, CustomMode, GroundMode);
+	switch (Mode)
 	{
-		return false;
+	case MOVE_Walking:
+	case MOVE_NavWalking:	INC_DWORD_STAT(STAT_TutCombineAttemptsWalking);		INC_DWORD_STAT_BY(STAT_TutCombineHitsWalking, bCanCombine);		break;
+	case MOVE_Falling:		INC_DWORD_STAT(STAT_TutCombineAttemptsFalling);		INC_DWORD_STAT_BY(STAT_TutCombineHitsFalling, bCanCombine);		break;
+	case MOVE_Flying:		INC_DWORD_STAT(STAT_TutCombineAttemptsFlying);		INC_DWORD_STAT_BY(STAT_TutCombineHitsFlying, bCanCombine);		break;
+	case MOVE_Custom:
+		if (CustomMode == MOVE_WallRunning)
+		{
+			INC_DWORD_STAT(STAT_TutCombineAttemptsWallRunning);
+			INC_DWORD_STAT_BY(STAT_TutCombineHitsWallRunning, bCanCombine);
+			break;
+		}
+		//Other custom modes are counted as other.
+		[[fallthrough]];
+	default:				INC_DWORD_STAT(STAT_TutCombineAttemptsOther);		INC_DWORD_STAT_BY(STAT_TutCombineHitsOther, bCanCombine);		break;
 	}
+#endif
 
-	if (bWallRunIsRightSaved != NewMovePtr->bWallRunIsRightSaved)
+	return bCanCombine;
+}
+
+bool FCustomSavedMove::CanCombineCustomState(const FCustomSavedMove& NewMove) const
+{
+	if (bWantsToSprintSaved != NewMove.bWantsToSprintSaved)
 	{
 		return false;
 	}
 
-	if (SavedMaxCustomSpeed != NewMovePtr->SavedMaxCustomSpeed)
+	if (bWallRunIsRightSaved != NewMove.bWallRunIsRightSaved)
 	{
 		return false;
 	}
 
-
-	if (SavedLaunchVelocityCustom != NewMovePtr->SavedLaunchVelocityCustom)
+	/*
+	* A launch is consumed by the move that carries it: OnMovementUpdated moves it into PendingLaunchVelocity once the move is done,
+	* and HandlePendingLaunch applies it at the start of the next move. Every move after it saves a zero launch again.
+	* - If only NewMove carries one, the combined move carries it too and ends when NewMove did, so the launch is applied on the same frame as before.
+	*   Nothing to merge in CombineWith, the launch is already in NewMove and still in LaunchVelocityCustom.
+	* - If this move carries one, it has already been handed to PendingLaunchVelocity. Combined, the server would apply it a move later than we did.
+	* There is no tolerance here. HandlePendingLaunch applies any launch that isn't exactly zero, and a launch overwrites Velocity, so even a tiny one matters.
+	*/
+	if (!SavedLaunchVelocityCustom.IsZero())
 	{
 		return false;
 	}
 
-	if (SavedMovementFlagCustom != NewMovePtr->SavedMovementFlagCustom)
+	//Bit flags, including the speed tier index. Either they match or they don't.
+	if (SavedMovementFlagCustom != NewMove.SavedMovementFlagCustom)
 	{
 		return false;
 	}
 
-	return Super::CanCombineWith(NewMove, Character, MaxDelta);
+	return true;
+}
+
+void FCustomSavedMove::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	const FCustomSavedMove* OldMovePtr = static_cast<const FCustomSavedMove*>(OldMove);
+
+	/*
+	* The probe cooldown ticks down every move, so the two moves never agree on it and CanCombineCustomState doesn't compare it.
+	* This move saved the cooldown as OldMove left it. The server replays the combined move from OldMove's cooldown, so we must too,
+	* otherwise TryWallRun probes on a different frame here than it does on the server.
+	*/
+	SavedWallRunProbeCooldown = OldMovePtr->SavedWallRunProbeCooldown;
+
+	UTutCharacterMovementComponent* CharacterMovement = Cast<UTutCharacterMovementComponent>(InCharacter->GetCharacterMovement());
+	if (CharacterMovement)
+	{
+		CharacterMovement->WallRunProbeCooldownRemaining = OldMovePtr->SavedWallRunProbeCooldown;
+	}
 }
 
 //Saves Move before Using
@@ -692,12 +1111,18 @@ void FCustomSavedMove::SetMoveFor(ACharacter* Character, float InDeltaTime, FVec
 	{
 		bWantsToSprintSaved = CharacterMovement->bWantsToSprint;
 		bWallRunIsRightSaved = CharacterMovement->bWallRunIsRight;
+		SavedWallRunProbeCooldown = CharacterMovement->WallRunProbeCooldownRemaining;
 
-		SavedMaxCustomSpeed = CharacterMovement->CustomMaxSpeed;
 		SavedLaunchVelocityCustom = CharacterMovement->LaunchVelocityCustom;
 
 		SavedMovementFlagCustom = CharacterMovement->MovementFlagCustom;
 
+		//Skips 0 when it wraps, which means no move.
+		MoveId = CharacterMovement->NextSavedMoveId++;
+		if (CharacterMovement->NextSavedMoveId == 0)
+		{
+			CharacterMovement->NextSavedMoveId = 1;
+		}
 	}
 
 }
@@ -711,9 +1136,14 @@ void FCustomSavedMove::PrepMoveFor(ACharacter* Character)
 	if (CharacterMovementComponent)
 	{
 		CharacterMovementComponent->bWantsToSprint = bWantsToSprintSaved;
-		CharacterMovementComponent->bWallRunIsRight = bWallRunIsRightSaved;
 
-		CharacterMovementComponent->CustomMaxSpeed = SavedMaxCustomSpeed;
+		//After a correction, derived state starts from the server's values and has to evolve from there, not jump back to what we mispredicted.
+		if (!CharacterMovementComponent->bReplayingCorrection)
+		{
+			CharacterMovementComponent->bWallRunIsRight = bWallRunIsRightSaved;
+			CharacterMovementComponent->WallRunProbeCooldownRemaining = SavedWallRunProbeCooldown;
+		}
+
 		CharacterMovementComponent->LaunchVelocityCustom = SavedLaunchVelocityCustom;
 
 		CharacterMovementComponent->MovementFlagCustom = SavedMovementFlagCustom;
@@ -728,12 +1158,14 @@ void FCustomSavedMove::Clear()
 
 	bWantsToSprintSaved = false;
 	bWallRunIsRightSaved = false;
+	SavedWallRunProbeCooldown = 0.f;
 
-	SavedMaxCustomSpeed = 800.f;
 	SavedLaunchVelocityCustom = FVector(0.f, 0.f, 0.f);
 
 
 	SavedMovementFlagCustom = 0;
+
+	MoveId = 0;
 }
 
 //Acquires prediction data from clients (boilerplate code)
@@ -751,6 +1183,26 @@ FNetworkPredictionData_Client* UTutCharacterMovementComponent::GetPredictionData
 	return ClientPredictionData;
 }
 
+void UTutCharacterMovementComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	if (ClientPredictionData)
+	{
+		CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetClientPredictionDataSize());
+	}
+}
+
+SIZE_T UTutCharacterMovementComponent::GetClientPredictionDataSize() const
+{
+	return static_cast<const FCustomNetworkPredictionData_Client*>(ClientPredictionData)->GetAllocatedSize();
+}
+
+const FCustomSavedMovePool::FCounters* UTutCharacterMovementComponent::GetSavedMovePoolCounters() const
+{
+	return ClientPredictionData ? &static_cast<const FCustomNetworkPredictionData_Client*>(ClientPredictionData)->GetSavedMovePoolCounters() : nullptr;
+}
+
 //An older function used more in versions of Unreal prior to the introduction of Packed Movement Data (FCharacterNetworkMoveData).
 //Can still be used for unpacking additional compressed flags within CustomSavedMove.
 uint8 FCustomSavedMove::GetCompressedFlags() const
@@ -761,20 +1213,306 @@ uint8 FCustomSavedMove::GetCompressedFlags() const
 }
 
 //Default constructor for FCustomNetworkPredictionData_Client. It's usually not necessary to populate this function.
-FCustomNetworkPredictionData_Client::FCustomNetworkPredictionData_Client(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement)
+//Enough for a full saved move list and a full free list at the same time. The parent constructor has already set both limits.
+FCustomNetworkPredictionData_Client::FCustomNetworkPredictionData_Client(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement), SavedMovePool(MaxSavedMoveCount + MaxFreeMoveCount)
 {
 }
 
-//Generates a new saved move that will be populated and used by the system.
-FSavedMovePtr FCustomNetworkPredictionData_Client::AllocateNewMove()
+//The server acknowledged one of our moves, so it can now be used as a delta baseline.
+void UTutCharacterMovementComponent::ClientAckGoodMove_Implementation(float TimeStamp)
 {
-	return FSavedMovePtr(new FCustomSavedMove());
+	/*
+	* The parent finds the acknowledged saved move by its time stamp, then drops it from SavedMoves. We look it up the same way first, so we agree with the parent
+	* on which move was acknowledged, and from then on only go by its MoveId. Matching our delta history against time stamps instead would compare floats that
+	* took different paths to get here, and can't tell apart moves that happened to share one.
+	*/
+	uint32 AckedMoveId = 0;
+	if (HasPredictionData_Client())
+	{
+		const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+		const int32 MoveIndex = ClientData->GetSavedMoveIndex(TimeStamp);
+		if (MoveIndex != INDEX_NONE)
+		{
+			AckedMoveId = static_cast<const FCustomSavedMove*>(ClientData->SavedMoves[MoveIndex].Get())->MoveId;
+		}
+	}
+
+	Super::ClientAckGoodMove_Implementation(TimeStamp);
+
+	if (AckedMoveId != 0)
+	{
+		MoveDataContainer.AcknowledgeMove(AckedMoveId);
+	}
 }
 
-//The Flags parameter contains the compressed input flags that are stored in the parent saved move.
-//UpdateFromCompressed flags simply copies the flags from the saved move into the movement component.
-//It basically just resets the movement component to the state when the move was made so it can simulate from there.
-//We use ClientFillNetworkMoveData instead of this function, due to the limitation of the original flags system.
+void UTutCharacterMovementComponent::ServerMovePacked_ClientSend(const FCharacterServerMovePackedBits& PackedBits)
+{
+	++NumServerMovesSent;
+	NumServerMoveBitsSent += PackedBits.DataBits.Num();
+
+	Super::ServerMovePacked_ClientSend(PackedBits);
+}
+
+void UTutCharacterMovementComponent::ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse)
+{
+	Super::ClientHandleMoveResponse(MoveResponse);
+
+	//The parent ignores stale or duplicate corrections. bUpdatePosition is only set once a correction has actually been applied.
+	FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+	if (MoveResponse.IsGoodMove() || !ClientData || !ClientData->bUpdatePosition)
+	{
+		return;
+	}
+
+	++NumClientCorrections;
+
+	const FCustomMoveResponseData& ResponseData = static_cast<const FCustomCharacterMoveResponseDataContainer&>(MoveResponse).CustomResponseData;
+	bWallRunIsRight = ResponseData.bWallRunIsRight;
+	WallRunProbeCooldownRemaining = ResponseData.WallRunProbeCooldownRemaining;
+	PendingLaunchVelocity = ResponseData.PendingLaunchVelocity;
+	//The cached hit was traced from where we thought we were, not from where the server put us.
+	WallContactCache.Reset();
+	//Flags are input, so each replayed move restores its own. These only matter if the server cleaned them up (an invalid speed tier, for example).
+	MovementFlagCustom = ResponseData.MovementFlagCustom;
+
+	bReplayingCorrection = true;
+}
+
+bool UTutCharacterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	//The replay restores each saved move's input, leaving the last saved move's values behind. Anything the player changed since then would be lost,
+	//including a launch requested after the last move.
+	const bool bRealWantsToSprint = bWantsToSprint;
+	const uint8 RealMovementFlagCustom = MovementFlagCustom;
+	const FVector RealLaunchVelocityCustom = LaunchVelocityCustom;
+
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+
+	bWantsToSprint = bRealWantsToSprint;
+	MovementFlagCustom = RealMovementFlagCustom;
+	LaunchVelocityCustom = RealLaunchVelocityCustom;
+	bReplayingCorrection = false;
+
+	return bResult;
+}
+
+bool UTutCharacterMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	const bool bNeedsCorrection = Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientWorldLocation, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+	NumServerCorrections += bNeedsCorrection;
+	if (!bNeedsCorrection || !FTutCorrectionTelemetry::IsEnabled())
+	{
+		return bNeedsCorrection;
+	}
+
+	//How long after a launch we still consider it a suspect. Launches tend to cause their corrections a few moves later, on landing.
+	static constexpr float RecentLaunchSeconds = 0.5f;
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	FTutCorrectionRecord Record;
+	Record.WorldTime = WorldTime;
+	Record.Frame = GFrameCounter;
+	Record.CharacterName = GetNameSafe(CharacterOwner);
+	Record.ServerMode = MovementMode;
+	Record.ServerCustomMode = CustomMovementMode;
+
+	TEnumAsByte<EMovementMode> ClientMode;
+	TEnumAsByte<EMovementMode> ClientGroundMode;
+	UnpackNetworkMovementMode(ClientMovementMode, ClientMode, Record.ClientCustomMode, ClientGroundMode);
+	Record.ClientMode = ClientMode;
+
+	Record.PositionError = FVector::Dist(ClientWorldLocation, UpdatedComponent->GetComponentLocation());
+	Record.TimeSinceModeChange = WorldTime - LastModeChangeTime;
+
+	//Actual disagreements: what the client sent with this move against the server's state after playing it.
+	const bool bClientWallRunning = Record.ClientMode == MOVE_Custom && Record.ClientCustomMode == MOVE_WallRunning;
+	if (Record.ClientMode != Record.ServerMode || (Record.ServerMode == MOVE_Custom && Record.ClientCustomMode != Record.ServerCustomMode))
+	{
+		Record.AddSuspect(ETutCorrectionSuspect::Mode);
+	}
+	const FCustomNetworkMoveData* CurrentMoveData = static_cast<FCustomNetworkMoveData*>(GetCurrentNetworkMoveData());
+	if (CurrentMoveData && CurrentMoveData->MovementFlagCustomMoveData != MovementFlagCustom)
+	{
+		Record.AddSuspect(ETutCorrectionSuspect::Flags);
+	}
+
+	//Heuristics: one of our features was in play, but the client doesn't send enough to tell whether the two sides disagreed on it.
+	if (bWantsToSprint && !bIsSprinting)
+	{
+		Record.AddSuspect(ETutCorrectionSuspect::Sprint);
+	}
+	if (IsWallRunning() && bClientWallRunning)
+	{
+		Record.AddSuspect(ETutCorrectionSuspect::WallRun);
+	}
+	const bool bLaunchInMove = CurrentMoveData && !CurrentMoveData->LaunchVelocityCustomMoveData.IsZero();
+	if (bLaunchInMove || !PendingLaunchVelocity.IsZero() || (LastLaunchTime >= 0.f && WorldTime - LastLaunchTime < RecentLaunchSeconds))
+	{
+		Record.AddSuspect(ETutCorrectionSuspect::Launch);
+	}
+	if (IsFlagActive((uint8)EMovementFlag::CFLAG_WantsToFly) != IsFlying())
+	{
+		Record.AddSuspect(ETutCorrectionSuspect::Fly);
+	}
+
+	if (const UNetConnection* Connection = CharacterOwner->GetNetConnection())
+	{
+		Record.InBytesPerSecond = Connection->InBytesPerSecond;
+		Record.OutBytesPerSecond = Connection->OutBytesPerSecond;
+	}
+
+	FTutCorrectionTelemetry::Get().Record(Record);
+
+	return bNeedsCorrection;
+}
+
+void FCustomCharacterMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+	Super::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+	CustomResponseData = FCustomMoveResponseData();
+
+	const UTutCharacterMovementComponent* TutMovement = Cast<UTutCharacterMovementComponent>(&CharacterMovement);
+	if (IsGoodMove() || !TutMovement)
+	{
+		return;
+	}
+
+	CustomResponseData.bWallRunIsRight = TutMovement->bWallRunIsRight;
+	CustomResponseData.MovementFlagCustom = TutMovement->MovementFlagCustom;
+	CustomResponseData.PendingLaunchVelocity = TutMovement->PendingLaunchVelocity;
+	CustomResponseData.WallRunProbeCooldownRemaining = TutMovement->WallRunProbeCooldownRemaining;
+}
+
+bool FCustomCharacterMoveResponseDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	if (!Super::Serialize(CharacterMovement, Ar, PackageMap))
+	{
+		return false;
+	}
+
+	//Both ends are the same class, so both make the same decision here.
+	const UTutCharacterMovementComponent* TutMovement = Cast<UTutCharacterMovementComponent>(&CharacterMovement);
+	if (IsGoodMove() || !TutMovement)
+	{
+		return !Ar.IsError();
+	}
+
+	const bool bIsSaving = Ar.IsSaving();
+	FCustomMoveResponseData& ResponseData = CustomResponseData;
+
+	Ar.SerializeBits(&ResponseData.bWallRunIsRight, 1);
+	SerializeOptionalValue<uint8>(bIsSaving, Ar, ResponseData.MovementFlagCustom, 0);
+
+	//Uses the same precision as the launch in our move data, so a quantized launch comes back exactly as it went out.
+	bool bHasPendingLaunch = bIsSaving && !ResponseData.PendingLaunchVelocity.IsZero();
+	Ar.SerializeBits(&bHasPendingLaunch, 1);
+	if (bHasPendingLaunch)
+	{
+		const FCustomMoveDataQuantization& Quantization = TutMovement->MoveDataQuantization;
+		if (Quantization.bQuantizeMoveData)
+		{
+			const uint32 MaxValue = 1u << Quantization.LaunchVelocityBitsPerComponent;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				uint32 Component = bIsSaving ? Quantization.QuantizeLaunchComponent(ResponseData.PendingLaunchVelocity[Axis]) : 0;
+				Ar.SerializeInt(Component, MaxValue);
+				ResponseData.PendingLaunchVelocity[Axis] = Quantization.DequantizeLaunchComponent(Component);
+			}
+		}
+		else
+		{
+			Ar << ResponseData.PendingLaunchVelocity;
+		}
+	}
+	else
+	{
+		ResponseData.PendingLaunchVelocity = FVector::ZeroVector;
+	}
+
+	//The cooldown only decides which frame we probe on next, so 8 bits of the full cooldown is plenty.
+	const float Cooldown = TutMovement->WallRunProbeCooldown;
+	bool bHasCooldown = bIsSaving && Cooldown > 0.f && ResponseData.WallRunProbeCooldownRemaining > 0.f;
+	Ar.SerializeBits(&bHasCooldown, 1);
+	if (bHasCooldown)
+	{
+		uint32 QuantizedCooldown = bIsSaving ? FMath::Clamp<uint32>(FMath::RoundToInt(ResponseData.WallRunProbeCooldownRemaining / Cooldown * 255.f), 1, 255) : 0;
+		Ar.SerializeInt(QuantizedCooldown, 256);
+		ResponseData.WallRunProbeCooldownRemaining = QuantizedCooldown * Cooldown / 255.f;
+	}
+	else
+	{
+		ResponseData.WallRunProbeCooldownRemaining = 0.f;
+	}
+
+	return !Ar.IsError();
+}
+
+//Generates a new saved move that will be populated and used by the system.
+FSavedMovePtr FCustomNetworkPredictionData_Client::AllocateNewMove()
+{
+	return SavedMovePool.Allocate();
+}
+
+FCustomSavedMovePool::FCustomSavedMovePool(int32 InCapacity) : Capacity(FMath::Max(InCapacity, 1))
+{
+}
+
+FCustomSavedMovePool::~FCustomSavedMovePool()
+{
+	DEC_DWORD_STAT_BY(STAT_TutSavedMovesPooled, Moves.Num());
+}
+
+SIZE_T FCustomSavedMovePool::GetAllocatedSize() const
+{
+	return Moves.GetAllocatedSize() + Moves.Num() * sizeof(FCustomSavedMove);
+}
+
+FSavedMovePtr FCustomSavedMovePool::Allocate()
+{
+	INC_DWORD_STAT(STAT_TutSavedMoveRequests);
+	++Counters.Requests;
+
+	//A reference count of 1 means only the pool still holds the move.
+	for (int32 Offset = 0; Offset < Moves.Num(); ++Offset)
+	{
+		const int32 Index = (SearchIndex + Offset) % Moves.Num();
+		if (Moves[Index].GetSharedReferenceCount() == 1)
+		{
+			SearchIndex = (Index + 1) % Moves.Num();
+			//Moves dropped past MaxFreeMoveCount were never cleared by the parent.
+			Moves[Index]->Clear();
+			return Moves[Index];
+		}
+	}
+
+	INC_DWORD_STAT(STAT_TutSavedMoveAllocations);
+	++Counters.Allocations;
+
+	if (Moves.Num() < Capacity)
+	{
+		//The first move anyone asks us for. From here on this character is saving moves, so make room for all of them at once.
+		if (Moves.Max() == 0)
+		{
+			Moves.Reserve(Capacity);
+		}
+
+		FSavedMovePtr& NewMove = Moves.Add_GetRef(MakeShared<FCustomSavedMove>());
+		Counters.HighWater = Moves.Num();
+		INC_DWORD_STAT(STAT_TutSavedMovesPooled);
+		return NewMove;
+	}
+
+	INC_DWORD_STAT(STAT_TutSavedMoveHeapFallbacks);
+	++Counters.HeapFallbacks;
+	return MakeShared<FCustomSavedMove>();
+}
+
+//The Flags parameter contains the compressed input flags that are stored in the parent saved move.
+//UpdateFromCompressed flags simply copies the flags from the saved move into the movement component.
+//It basically just resets the movement component to the state when the move was made so it can simulate from there.
+//We use ClientFillNetworkMoveData instead of this function, due to the limitation of the original flags system.
 void UTutCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
 {
 	Super::UpdateFromCompressedFlags(Flags);
@@ -790,5 +1528,412 @@ FCustomCharacterNetworkMoveDataContainer::FCustomCharacterNetworkMoveDataContain
 	OldMoveData = &CustomDefaultMoveData[2];
 }
 
+/*
+* Delta encoding header, written before the usual New/Pending/Old moves:
+* 4 bits: sequence slot of the New move.
+* 1 bit: whether the New move is encoded against an acknowledged move.
+* 4 bits (optional): sequence slot of that acknowledged move.
+* The client only references an acknowledged move while fewer than DeltaHistorySize moves have been sent since, so the server's slot can't have been overwritten yet.
+*/
+bool FCustomCharacterNetworkMoveDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	TUT_MOVEMENT_SCOPE(SerializeMoveContainer);
+
+	FCustomNetworkMoveData& NewMove = CustomDefaultMoveData[0];
+
+	const UTutCharacterMovementComponent* TutMovement = Cast<UTutCharacterMovementComponent>(&CharacterMovement);
+	if (!TutMovement || !TutMovement->bDeltaEncodeMoveData)
+	{
+		for (FCustomNetworkMoveData& MoveData : CustomDefaultMoveData)
+		{
+			MoveData.DeltaBaseline = nullptr;
+		}
+		return Super::Serialize(CharacterMovement, Ar, PackageMap);
+	}
+
+	if (!DeltaHistory)
+	{
+		DeltaHistory = MakeUnique<FMoveDeltaHistory>();
+	}
+
+	const bool bIsSaving = Ar.IsSaving();
+	uint32 Sequence = 0;
+	bool bHasBaseline = false;
+	if (bIsSaving)
+	{
+		Sequence = DeltaHistory->NextSequence++;
+		bHasBaseline = DeltaHistory->bHasAckedMove && (Sequence - DeltaHistory->AckedSequence) < DeltaHistorySize;
+	}
+
+	uint32 Slot = Sequence % DeltaHistorySize;
+	Ar.SerializeInt(Slot, DeltaHistorySize);
+
+	Ar.SerializeBits(&bHasBaseline, 1);
+	NewMove.DeltaBaseline = nullptr;
+	if (bHasBaseline)
+	{
+		uint32 BaselineSlot = DeltaHistory->AckedSequence % DeltaHistorySize;
+		Ar.SerializeInt(BaselineSlot, DeltaHistorySize);
+
+		//The server has never seen this move, so we can't decode anything that follows.
+		if (Ar.IsError() || !DeltaHistory->bValid[BaselineSlot])
+		{
+			Ar.SetError();
+			return false;
+		}
+		NewMove.DeltaBaseline = &DeltaHistory->Moves[BaselineSlot];
+	}
+
+	CustomDefaultMoveData[1].DeltaBaseline = &NewMove;
+	CustomDefaultMoveData[2].DeltaBaseline = &NewMove;
+
+	if (!Super::Serialize(CharacterMovement, Ar, PackageMap))
+	{
+		return false;
+	}
+
+	//Remember this move so it can be used as a baseline once it is acknowledged.
+	FCustomNetworkMoveData& Recorded = DeltaHistory->Moves[Slot];
+	Recorded = NewMove;
+	Recorded.DeltaBaseline = nullptr;
+	DeltaHistory->Sequences[Slot] = Sequence;
+	DeltaHistory->MoveIds[Slot] = bIsSaving ? NewMove.MoveId : 0;
+	DeltaHistory->bValid[Slot] = true;
+
+	return true;
+}
+
+void FCustomCharacterNetworkMoveDataContainer::AcknowledgeMove(uint32 MoveId)
+{
+	if (!DeltaHistory)
+	{
+		return;
+	}
+
+	for (uint32 Slot = 0; Slot < DeltaHistorySize; ++Slot)
+	{
+		if (DeltaHistory->bValid[Slot] && DeltaHistory->MoveIds[Slot] == MoveId)
+		{
+			const uint32 Sequence = DeltaHistory->Sequences[Slot];
+			//Acks can arrive out of order, only ever move the baseline forward.
+			if (!DeltaHistory->bHasAckedMove || (int32)(Sequence - DeltaHistory->AckedSequence) > 0)
+			{
+				DeltaHistory->AckedSequence = Sequence;
+				DeltaHistory->bHasAckedMove = true;
+			}
+			return;
+		}
+	}
+}
+
+#pragma endregion
+/////END Networking/////
+#pragma region Simulated Proxy LOD
+
+static bool GTutProxyLOD = true;
+static FAutoConsoleVariableRef CVarTutProxyLOD(
+	TEXT("tut.Movement.ProxyLOD"),
+	GTutProxyLOD,
+	TEXT("Lower the tick rate of distant or unseen simulated proxies, and stop simulating the furthest ones. See UTutCharacterMovementComponent::bEnableSimulatedProxyLOD."));
+
+//Keeps the number of proxies in each tier up to date in "stat TutMovement".
+static void CountProxyLOD(ETutProxyLOD LOD, bool bAdd)
+{
+	switch (LOD)
+	{
+	case ETutProxyLOD::Full:	if (bAdd) { INC_DWORD_STAT(STAT_TutProxyLODFull); }		else { DEC_DWORD_STAT(STAT_TutProxyLODFull); }		break;
+	case ETutProxyLOD::Reduced:	if (bAdd) { INC_DWORD_STAT(STAT_TutProxyLODReduced); }	else { DEC_DWORD_STAT(STAT_TutProxyLODReduced); }	break;
+	case ETutProxyLOD::Frozen:	if (bAdd) { INC_DWORD_STAT(STAT_TutProxyLODFrozen); }	else { DEC_DWORD_STAT(STAT_TutProxyLODFrozen); }	break;
+	}
+}
+
+void UTutCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	if (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		if (!bProxyLODActive)
+		{
+			bProxyLODActive = true;
+			FullLODSmoothingMode = NetworkSmoothingMode;
+			CountProxyLOD(ProxyLOD, true);
+			//Spread the updates out, so a crowd that spawned together doesn't pick its tiers on the same frame.
+			ProxyLODTimeUntilUpdate = FMath::FRand() * ProxyLODUpdateInterval;
+		}
+
+		ProxyLODTimeUntilUpdate -= DeltaTime;
+		if (ProxyLODTimeUntilUpdate <= 0.f)
+		{
+			ProxyLODTimeUntilUpdate = ProxyLODUpdateInterval;
+			SetProxyLOD(bEnableSimulatedProxyLOD && GTutProxyLOD ? ComputeProxyLOD() : ETutProxyLOD::Full);
+		}
+
+		if (ProxyLOD == ETutProxyLOD::Frozen)
+		{
+			return;
+		}
+	}
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+ETutProxyLOD UTutCharacterMovementComponent::ComputeProxyLOD() const
+{
+	//Distance to the closest local player's view. With split screen, every player counts.
+	float ClosestDistanceSquared = MAX_flt;
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, float(FVector::DistSquared(ViewLocation, Location)));
+		}
+	}
+
+	//Coming back up a tier takes getting a little closer than going down did, so a proxy on the boundary doesn't flip every update.
+	const float ReducedDistance = ProxyLODReducedDistance * (ProxyLOD >= ETutProxyLOD::Reduced ? 1.f - ProxyLODHysteresis : 1.f);
+	const float FrozenDistance = ProxyLODFrozenDistance * (ProxyLOD == ETutProxyLOD::Frozen ? 1.f - ProxyLODHysteresis : 1.f);
+
+	ETutProxyLOD NewLOD = ETutProxyLOD::Full;
+	if (ClosestDistanceSquared > FMath::Square(FrozenDistance))
+	{
+		NewLOD = ETutProxyLOD::Frozen;
+	}
+	else if (ClosestDistanceSquared > FMath::Square(ReducedDistance))
+	{
+		NewLOD = ETutProxyLOD::Reduced;
+	}
+
+	//Nobody has seen it lately, so nobody will notice it being one tier cheaper.
+	//Without a renderer (-nullrhi, soak and benchmark clients) nothing is ever rendered, which says nothing about whether anyone would see it.
+	if (NewLOD != ETutProxyLOD::Frozen && FApp::CanEverRender() && !CharacterOwner->WasRecentlyRendered(ProxyLODRenderedTolerance))
+	{
+		NewLOD = ETutProxyLOD(uint8(NewLOD) + 1);
+	}
+
+	return NewLOD;
+}
+
+void UTutCharacterMovementComponent::SetProxyLOD(ETutProxyLOD NewLOD)
+{
+	if (NewLOD == ProxyLOD)
+	{
+		return;
+	}
+
+	CountProxyLOD(ProxyLOD, false);
+	CountProxyLOD(NewLOD, true);
+
+	const ETutProxyLOD PreviousLOD = ProxyLOD;
+	ProxyLOD = NewLOD;
+
+	switch (ProxyLOD)
+	{
+	case ETutProxyLOD::Full:
+		SetComponentTickInterval(0.f);
+		NetworkSmoothingMode = FullLODSmoothingMode;
+		break;
+	case ETutProxyLOD::Reduced:
+		SetComponentTickInterval(ProxyLODReducedTickInterval);
+		NetworkSmoothingMode = FullLODSmoothingMode;
+		break;
+	case ETutProxyLOD::Frozen:
+	{
+		//We still tick, but only to pick our tier again.
+		SetComponentTickInterval(ProxyLODUpdateInterval);
+
+		//Nothing will smooth the mesh from here on, so finish the smoothing now and let replicated updates move us directly.
+		if (FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character())
+		{
+			ClientData->MeshTranslationOffset = FVector::ZeroVector;
+			ClientData->MeshRotationOffset = ClientData->MeshRotationTarget;
+			SmoothClientPosition_UpdateVisuals();
+		}
+		bNetworkSmoothingComplete = true;
+		NetworkSmoothingMode = ENetworkSmoothingMode::Disabled;
+		break;
+	}
+	}
+
+	//Catch the mode events up with whatever happened while we were frozen.
+	if (PreviousLOD == ETutProxyLOD::Frozen && bModeEventsDeferred)
+	{
+		bModeEventsDeferred = false;
+		if (DeferredEventMode != MovementMode || (MovementMode == MOVE_Custom && DeferredEventCustomMode != CustomMovementMode))
+		{
+			CallMovementModeExit(DeferredEventMode, DeferredEventCustomMode);
+			CallMovementModeEnter(MovementMode, CustomMovementMode);
+		}
+	}
+}
+
+#pragma endregion
+
+#pragma region Input Recording
+
+void UTutCharacterMovementComponent::StartInputRecording(const FString& Name)
+{
+	if (!CharacterOwner)
+	{
+		return;
+	}
+
+	InputRecording = MakeShared<FTutMovementRecording>();
+	InputRecording->MapName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	InputRecording->CharacterClassPath = CharacterOwner->GetClass()->GetPathName();
+	InputRecording->StartState = FTutRecordedMovementState::Capture(*this);
+	InputRecordingFilename = FTutMovementRecording::ResolveFilename(Name);
+
+	UE_LOG(LogTemp, Display, TEXT("Recording movement input of %s to %s"), *CharacterOwner->GetName(), *InputRecordingFilename);
+}
+
+TSharedPtr<FTutMovementRecording> UTutCharacterMovementComponent::StopInputRecording()
+{
+	TSharedPtr<FTutMovementRecording> Recording = MoveTemp(InputRecording);
+	if (!Recording)
+	{
+		return nullptr;
+	}
+
+	Recording->EndState = FTutRecordedMovementState::Capture(*this);
+	if (Recording->SaveToFile(InputRecordingFilename))
+	{
+		UE_LOG(LogTemp, Display, TEXT("Saved %d frames of movement input to %s"), Recording->Frames.Num(), *InputRecordingFilename);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to save movement input to %s"), *InputRecordingFilename);
+	}
+	return Recording;
+}
+
+void UTutCharacterMovementComponent::StartInputReplay(TSharedPtr<const FTutMovementRecording> Recording)
+{
+	InputReplay = MoveTemp(Recording);
+	InputReplayFrame = 0;
+}
+
+void UTutCharacterMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//Whatever ends the session, keep what we recorded of it.
+	StopInputRecording();
+
+	if (bManagedByMovementManager)
+	{
+		if (UTutMovementManagerSubsystem* Manager = GetWorld()->GetSubsystem<UTutMovementManagerSubsystem>())
+		{
+			Manager->Unregister(this);
+		}
+	}
+
+	if (bProxyLODActive)
+	{
+		CountProxyLOD(ProxyLOD, false);
+		bProxyLODActive = false;
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTutCharacterMovementComponent::ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds)
+{
+	if (IsReplayingInput())
+	{
+		const FTutRecordedMoveInput& Frame = InputReplay->Frames[InputReplayFrame++];
+		bWantsToSprint = Frame.bWantsToSprint;
+		MovementFlagCustom = Frame.MovementFlagCustom;
+		if (!Frame.LaunchVelocity.IsZero())
+		{
+			LaunchVelocityCustom = Frame.LaunchVelocity;
+		}
+
+		//Go through Jump and StopJumping, like the player's input does, so the character's jump state is reset the same way.
+		if (Frame.bPressedJump && !CharacterOwner->bPressedJump)
+		{
+			CharacterOwner->Jump();
+		}
+		else if (!Frame.bPressedJump && CharacterOwner->bPressedJump)
+		{
+			CharacterOwner->StopJumping();
+		}
+
+		Super::ControlledCharacterMove(Frame.InputVector, DeltaSeconds);
+		return;
+	}
+
+	if (!bCheckedAutoRecord)
+	{
+		bCheckedAutoRecord = true;
+		static const bool bAutoRecord = FParse::Param(FCommandLine::Get(), TEXT("TutRecordInput"));
+		if (bAutoRecord && CharacterOwner->IsLocallyControlled())
+		{
+			StartInputRecording();
+		}
+	}
+
+	if (InputRecording)
+	{
+		FTutRecordedMoveInput& Frame = InputRecording->Frames.AddDefaulted_GetRef();
+		Frame.DeltaSeconds = DeltaSeconds;
+		Frame.InputVector = InputVector;
+		Frame.bWantsToSprint = bWantsToSprint;
+		Frame.bPressedJump = CharacterOwner->bPressedJump;
+		Frame.MovementFlagCustom = MovementFlagCustom;
+		Frame.LaunchVelocity = LaunchVelocityCustom;
+	}
+
+	Super::ControlledCharacterMove(InputVector, DeltaSeconds);
+}
+
+#pragma endregion
+
+#pragma region Movement Manager
+
+bool UTutCharacterMovementComponent::CanUseMovementManager() const
+{
+	return CustomCharacter && CharacterOwner->HasAuthority() && !CharacterOwner->IsPlayerControlled();
+}
+
+void UTutCharacterMovementComponent::SetPrecomputedWallProbe(const FTutWallProbeQuery& Query, const FTutWallProbeResult& Result)
+{
+	PrecomputedWallProbeQuery = Query;
+	PrecomputedWallProbe = Result;
+	bHasPrecomputedWallProbe = true;
+}
+
+bool UTutCharacterMovementComponent::CanUseBatchedGates() const
+{
+	return UsesBaseMovementGates() && PendingLaunchVelocity.IsZero() && PendingImpulseToApply.IsZero() && PendingForceToApply.IsZero() && !HasRootMotionSources();
+}
+
+bool UTutCharacterMovementComponent::UsesBaseMovementGates() const
+{
+	return IsOfNativeClass(UTutCharacterMovementComponent::StaticClass());
+}
+
+bool UTutCharacterMovementComponent::IsOfNativeClass(const UClass* NativeClass) const
+{
+	const UClass* Class = GetClass();
+	while (Class && !Class->HasAnyClassFlags(CLASS_Native))
+	{
+		Class = Class->GetSuperClass();
+	}
+	return Class == NativeClass;
+}
+
+void UTutCharacterMovementComponent::OnControllerChanged()
+{
+	if (!bManagedByMovementManager)
+	{
+		return;
+	}
+
+	if (UTutMovementManagerSubsystem* Manager = GetWorld()->GetSubsystem<UTutMovementManagerSubsystem>())
+	{
+		Manager->UpdateControllerPrerequisite(this);
+	}
+}
+
 #pragma endregion
-/////END Networking/////
\ No newline at end of file
@@ -6,6 +6,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "TutWallProbe.h"
+#include "TutCurveLUT.h"
+#include "TutMovementRecording.h"
+#include "TutMovementModeRegistry.h"
 #include "TutCharacterMovementComponent.generated.h"
 
 /////BEGIN Network Prediction Setup/////
@@ -31,6 +35,37 @@
 * It is best to watch the accompanying YouTube tutorial to better understand this code.
 */
 
+/*
+* Optional quantization for our custom move data.
+* By default, SerializeOptionalValue sends a full-precision value whenever it differs from its default. For an FVector in UE5 that is three doubles (192 bits)!
+* Most gameplay values don't need that precision, so we can clamp them to a known range and send a fixed number of bits instead.
+* The settings live on the movement component defaults, which means the client and server always agree on the layout.
+* IMPORTANT: The client must simulate with the same rounded values the server will receive, otherwise every quantized move is a potential correction.
+* This is why we round LaunchVelocityCustom on the client as soon as it is set, not just when it is written to the archive.
+* (The custom speed doesn't need this, it is sent as a speed tier index packed into MovementFlagCustom.)
+*/
+USTRUCT(BlueprintType)
+struct FCustomMoveDataQuantization
+{
+	GENERATED_BODY()
+
+	//When false, the custom move data is sent at full precision (the original behaviour).
+	UPROPERTY(EditDefaultsOnly, Category = "Quantization")
+	bool bQuantizeMoveData = false;
+
+	//Each launch velocity component is clamped to +/- this range before it is quantized.
+	UPROPERTY(EditDefaultsOnly, Category = "Quantization", meta = (ClampMin = "1.0", EditCondition = "bQuantizeMoveData"))
+	float MaxLaunchVelocity = 4000.f;
+
+	//Bits sent per launch velocity axis. 16 bits over +/- 4000 gives a step of roughly 0.12 cm/s.
+	UPROPERTY(EditDefaultsOnly, Category = "Quantization", meta = (ClampMin = "2", ClampMax = "24", EditCondition = "bQuantizeMoveData"))
+	int32 LaunchVelocityBitsPerComponent = 16;
+
+	uint32 QuantizeLaunchComponent(float Value) const;
+	float DequantizeLaunchComponent(uint32 QuantizedValue) const;
+	FVector RoundLaunchVelocity(const FVector& LaunchVelocity) const;
+};
+
 //Network Move DATA
 //This new Move Data system enables much more flexibility.
 //Before, using the old compressed flags approach, we were limited to around 8 flags.
@@ -52,7 +87,7 @@ public:
 	bool bWantsToSprintMoveData = false; 
 
 	//UNSAFE variables
-	float MaxCustomSpeedMoveData = 800.f;
+	//There is no custom speed here. The client only sends a speed tier index inside MovementFlagCustomMoveData and the server looks up the actual speed.
 	FVector LaunchVelocityCustomMoveData = FVector(0.f, 0.f, 0.f);
 	
 	//This bypasses the limitations of the typical compressed flags used in past versions of UE4. 
@@ -60,7 +95,25 @@ public:
 	//Imagine hundreds of clients sending this info every tick. Even a small saving can add up significantly, especially when considering server costs.
 	//It is up to you to decide if you prefer sending bools like above or using the lightweight bitflag approach like below.
 	//If you're making P2P games, casual online, or co-op vs AI, etc, then you might not care too much about maximising efficiency. The bool approach might be more readable.
-	uint8 MovementFlagCustomMoveData = 0; 
+	uint8 MovementFlagCustomMoveData = 0;
+
+	/*
+	* The move our custom fields are compared against when serializing. Set by the container right before each Serialize call.
+	* When null, we compare against the hardcoded defaults, which is exactly the original behaviour.
+	* Any field equal to the baseline only costs a single bit.
+	*/
+	const FCustomNetworkMoveData* DeltaBaseline = nullptr;
+
+	//Owning client only, never sent: FCustomSavedMove::MoveId of the saved move this was filled from.
+	uint32 MoveId = 0;
+
+protected:
+
+	//Returns DeltaBaseline, or a default constructed move when there is none.
+	const FCustomNetworkMoveData& GetDeltaBaseline() const;
+
+	//Bit-packed alternative to the SerializeOptionalValue path, used when FCustomMoveDataQuantization::bQuantizeMoveData is enabled.
+	void SerializeQuantized(const FCustomMoveDataQuantization& Quantization, FArchive& Ar);
 };
 
 class FCustomCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
@@ -68,9 +121,78 @@ class FCustomCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDat
 
 public:
 
+	typedef FCharacterNetworkMoveDataContainer Super;
+
 	FCustomCharacterNetworkMoveDataContainer();
 
+	/*
+	* When delta encoding is enabled, the Pending and Old moves are encoded against the New move,
+	* and the New move is encoded against the last move the server acknowledged.
+	* Each packet carries a small sequence number so the server knows which of its recently received moves the client used as a baseline.
+	*/
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+
+	//Called on the owning client when the server acknowledges the saved move with this FCustomSavedMove::MoveId. It becomes the baseline for future moves.
+	void AcknowledgeMove(uint32 MoveId);
+
 	FCustomNetworkMoveData CustomDefaultMoveData[3];
+
+protected:
+
+	//How many moves we remember for delta encoding. Sequence numbers are sent modulo this size, so it must be a power of two.
+	static constexpr uint32 DeltaHistorySize = 16;
+
+	//Recently sent (client) or received (server) New moves, indexed by sequence number.
+	struct FMoveDeltaHistory
+	{
+		FCustomNetworkMoveData Moves[DeltaHistorySize];
+		uint32 Sequences[DeltaHistorySize] = {};
+		//Client only. Which saved move each slot was sent for, so acknowledgements can find it.
+		uint32 MoveIds[DeltaHistorySize] = {};
+		bool bValid[DeltaHistorySize] = {};
+
+		uint32 NextSequence = 0;
+		uint32 AckedSequence = 0;
+		bool bHasAckedMove = false;
+	};
+
+	//Only allocated once a delta encoded move is serialized, so characters that never send or receive moves don't pay for it.
+	TUniquePtr<FMoveDeltaHistory> DeltaHistory;
+};
+
+//Server Move RESPONSE Data
+/*
+* Our custom state, as the server had it when it corrected the client.
+* A correction already resets location, velocity and movement mode, but not the state our own code works out while moving, such as which side the wall is on.
+* Without this, the client replays its saved moves starting from its own mispredicted values, goes wrong in the same way, and gets corrected again.
+*/
+struct FCustomMoveResponseData
+{
+	bool bWallRunIsRight = false;
+
+	uint8 MovementFlagCustom = 0;
+
+	//A launch the server has accepted but not applied yet. HandlePendingLaunch applies it at the start of the next move.
+	FVector PendingLaunchVelocity = FVector::ZeroVector;
+
+	float WallRunProbeCooldownRemaining = 0.f;
+};
+
+/*
+* Sends FCustomMoveResponseData along with corrections. Good moves (the vast majority) don't carry any of it.
+* Cost per correction: 1 bit wall side, 1 bit + 8 if flags are set, 1 bit + launch if one is pending, 1 bit + 8 if a probe cooldown is running.
+*/
+class FCustomCharacterMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+public:
+
+	typedef FCharacterMoveResponseDataContainer Super;
+
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+
+	FCustomMoveResponseData CustomResponseData;
 };
 
 //Class FCustomSavedMove
@@ -89,6 +211,9 @@ public:
 	//However, we still save it for replay purposes.
 	bool bWallRunIsRightSaved = false; 
 
+	//Also inferred rather than sent. If we didn't restore it, a replayed move could probe for a wall on a different frame than the original move did.
+	float SavedWallRunProbeCooldown = 0.f;
+
 	//As you can see, our bWantsToFly variable is not present in MoveData or here in SavedMove like bWantsToSprint is. We use the info from MovementFlagCustomMoveData to change our state and save it as SavedMovementFlagCustom.
 	//This is because Move Data is sent back and forth, much like the Compressed Flags were sent in the old system (before packed move data).
 	//Thus, we aim to minimise the number of variables in our Move Data for the sake of network performance.
@@ -99,9 +224,11 @@ public:
 	uint8 SavedMovementFlagCustom = 0;
 	
 	//Variables
-	float SavedMaxCustomSpeed = 800.f;
 	FVector SavedLaunchVelocityCustom = FVector(0.f, 0.f, 0.f);	
 
+	//Unique per move on this client, and never 0 once the move is set up. Saved moves are recycled, so their address can't identify them.
+	uint32 MoveId = 0;
+
 
 	/** Returns a byte containing encoded special movement information (jumping, crouching, etc.)	 */
 	virtual uint8 GetCompressedFlags() const override;
@@ -111,6 +238,11 @@ public:
 	*/
 	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const override;
 
+	/** Combine this move with an older one, OldMove, and rewind the character to where OldMove started so the combined move can be played from there.
+	* The parent rewinds location, velocity and the floor. We also rewind the state our own code derives while moving, or the combined move would start from the end of OldMove.
+	*/
+	virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override;
+
 	/** Called to set up this saved move (when initially created) to make a predictive correction. */
 	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
 	/** Called before ClientUpdatePosition uses this SavedMove to make a predictive correction	 */
@@ -118,6 +250,61 @@ public:
 
 	/** Clear saved move properties, so it can be re-used. */
 	virtual void Clear() override;
+
+protected:
+
+	//Our half of CanCombineWith, kept apart so every attempt can be counted in one place.
+	bool CanCombineCustomState(const FCustomSavedMove& NewMove) const;
+};
+
+/*
+* A fixed-capacity pool of saved moves.
+* The parent prediction data already recycles moves through its FreeMoves list, but only up to MaxFreeMoveCount. Any move beyond that, and every move dropped when
+* the saved move list is reset, is freed, and with a lot of packet loss and a high ping the list keeps growing and shrinking. Each of those is a fresh allocation
+* for the move and another for its shared pointer.
+* The pool holds its own reference to every move it creates. Once nobody else references a move it is free again, so we hand it back out after a Clear()
+* instead of allocating. Only once the pool is full do we fall back to the heap.
+* Nothing is allocated until the first move is requested, so characters that never save a move (simulated proxies) don't pay for the pool.
+*/
+class FCustomSavedMovePool
+{
+public:
+
+	explicit FCustomSavedMovePool(int32 InCapacity);
+	~FCustomSavedMovePool();
+
+	FSavedMovePtr Allocate();
+
+	//How many moves the pool has created so far.
+	int32 Num() const { return Moves.Num(); }
+
+	//The pool's array and every move it created.
+	SIZE_T GetAllocatedSize() const;
+
+	//What this pool has been asked for over its lifetime. Counted in every build, for the net soak report.
+	struct FCounters
+	{
+		//Every Allocate call.
+		uint32 Requests = 0;
+		//Requests that had to create a move, in the pool or on the heap.
+		uint32 Allocations = 0;
+		//Requests made while the pool was full and every move in it was in use.
+		uint32 HeapFallbacks = 0;
+		//The most moves the pool has held. It never shrinks, so this is also its current size.
+		int32 HighWater = 0;
+	};
+
+	const FCounters& GetCounters() const { return Counters; }
+
+private:
+
+	TArray<FSavedMovePtr> Moves;
+	int32 Capacity;
+
+	FCounters Counters;
+
+	//Where the next search for a free move starts. Recently freed moves tend to be just behind the last one handed out.
+	int32 SearchIndex = 0;
 };
 
 //Class Prediction Data
@@ -128,8 +315,17 @@ public:
 
 	typedef FNetworkPredictionData_Client_Character Super;
 
-	///Allocates a new copy of our custom saved move
+	///Allocates a new copy of our custom saved move, from the pool where possible
 	virtual FSavedMovePtr AllocateNewMove() override;
+
+	//This object plus its saved move pool.
+	SIZE_T GetAllocatedSize() const { return sizeof(*this) + SavedMovePool.GetAllocatedSize(); }
+
+	const FCustomSavedMovePool::FCounters& GetSavedMovePoolCounters() const { return SavedMovePool.GetCounters(); }
+
+protected:
+
+	FCustomSavedMovePool SavedMovePool;
 };
 
 #pragma endregion
@@ -142,11 +338,13 @@ public:
 * There can be a wide range of movement modes, depending on your game.
 * Examples: Wall-running, grappling, sliding, parkouring, etc.
 * In this tutorial, we will only cover wall running.
+* New modes go before MOVE_CustomMAX, and get their handlers registered in UTutCharacterMovementComponent::CustomModes.
 */
 UENUM(BlueprintType)
 enum ECustomMovementMode {
 	MOVE_CustomNone UMETA(Hidden),
 	MOVE_WallRunning   UMETA(DisplayName = "WallRunning"),
+	MOVE_CustomMAX UMETA(Hidden),
 };
 
 /* Our optimised movement flag container.
@@ -165,6 +363,90 @@ enum class EMovementFlag : uint8
 	CFLAG_OtherFlag1 = 1 << 1, //This could be used as CFLAG_WantsToSprint and follow the same logic as CFLAG_WantsToFly. Instead, this tutorial demonstrates both approaches for you to decide your preference. But keep your project requirements in mind in regards to bitrate.
 	CFLAG_OtherFlag2 = 1 << 2,
 	CFLAG_OtherFlag3 = 1 << 3,
+
+	//Bits 4-7 are not flags. They hold the current speed tier index, see UTutCharacterMovementComponent::SpeedTiers.
+};
+
+/*
+* A named speed that the character can move at while sprinting.
+* Clients never send a speed, only an index into the SpeedTiers table. Both the client and the server resolve the speed from the same table,
+* so a modified client can't ask for a speed the designers didn't author.
+*/
+USTRUCT(BlueprintType)
+struct FCustomSpeedTier
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Sprinting")
+	FName Name;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Sprinting", meta = (ClampMin = "0.0"))
+	float MaxSpeed = 800.f;
+};
+
+/*
+* How much work a simulated proxy (another player's character, as seen on our client) is allowed to cost. See the Simulated Proxy LOD section of UTutCharacterMovementComponent.
+*/
+UENUM(BlueprintType)
+enum class ETutProxyLOD : uint8
+{
+	//Simulated and smoothed every frame, exactly like an unmodified character.
+	Full,
+	//Simulated and smoothed at a lower tick rate.
+	Reduced,
+	//Not simulated or smoothed at all. Each replicated update moves the character straight into place, and movement mode events wait until it comes back.
+	Frozen,
+};
+
+/*
+* The custom movement state simulated proxies need, quantized into a single byte (7 bits on the wire):
+* sprinting, the wall run side, flying, and the custom movement mode those belong to.
+* Custom movement modes must fit in 4 bits.
+*/
+USTRUCT(BlueprintType)
+struct FTutReplicatedMovementState
+{
+	GENERATED_BODY()
+
+	FTutReplicatedMovementState() = default;
+	FTutReplicatedMovementState(bool bIsSprinting, bool bWallRunIsRight, bool bIsFlying, uint8 CustomMovementMode);
+
+	bool IsSprinting() const { return (Packed & SprintingBit) != 0; }
+	bool IsWallRunRight() const { return (Packed & WallRunRightBit) != 0; }
+	bool IsFlying() const { return (Packed & FlyingBit) != 0; }
+	uint8 GetCustomMovementMode() const { return Packed >> CustomModeShift; }
+
+	//The raw bits, for serializers that quantize the state themselves (see TutMovementIrisSerializers.cpp).
+	uint8 GetPacked() const { return Packed; }
+	static FTutReplicatedMovementState FromPacked(uint8 InPacked) { FTutReplicatedMovementState State; State.Packed = InPacked & ((1 << NumBits) - 1); return State; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FTutReplicatedMovementState& Other) const { return Packed == Other.Packed; }
+	bool operator!=(const FTutReplicatedMovementState& Other) const { return Packed != Other.Packed; }
+
+	static constexpr uint8 SprintingBit = 1 << 0;
+	static constexpr uint8 WallRunRightBit = 1 << 1;
+	static constexpr uint8 FlyingBit = 1 << 2;
+	static constexpr uint8 CustomModeShift = 3;
+	static constexpr uint8 CustomModeBits = 4;
+	static constexpr uint8 NumBits = CustomModeShift + CustomModeBits;
+
+private:
+
+	UPROPERTY()
+	uint8 Packed = 0;
+};
+
+template<>
+struct TStructOpsTypeTraits<FTutReplicatedMovementState> : public TStructOpsTypeTraitsBase2<FTutReplicatedMovementState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		//Replication compares the one byte, instead of walking the struct's properties.
+		WithIdenticalViaEquality = true,
+	};
 };
 
 /**
@@ -175,6 +457,7 @@ enum class EMovementFlag : uint8
  * There are certainly exceptions to this rule, such as reducing the need to include common classes by hosting them within a certain header file.
  */
 class AMyCustomCharacter;
+class AController;
 
 /**
  *
@@ -191,6 +474,9 @@ public:
 	//Reference to our network prediction buddy, the custom saved move class created above. 
 	friend class FCustomSavedMove;
 
+	//Reads our derived state on the server when filling in a correction.
+	friend class FCustomCharacterMoveResponseDataContainer;
+
 	/////BEGIN Sprinting/////
 
 	/*
@@ -216,16 +502,43 @@ public:
 	* This variable controls the actual sprinting logic. If it's true, the character will be moving at a higher velocity.
 	* It can be used as an internal CMC variable to track a gameplay tag that is applied/removed by GAS (e.g. State.Movement.Sprinting or State.Buff.Sprinting, depending on preference and design).
 	* But in this basic tutorial, we will use it directly.
-	* This is replicated as we want this variable to propagate down to simulated proxies (other clients).
+	* Simulated proxies (other clients) need it too, so the server sends it to them inside ReplicatedMovementState.
 	*/
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Sprinting")
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Sprinting")
 	bool bIsSprinting;
 
 	/*
-	* The current maximum speed that the character can run.
+	* The speeds the character can sprint at (sprint, buffed sprint, encumbered, and so on).
+	* The active tier index is stored in the upper bits of MovementFlagCustom, which means it is sent to the server for free alongside our other flags.
+	* Up to 16 tiers are supported. Invalid indices fall back to tier 0.
 	*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Sprinting")
-	float CustomMaxSpeed;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Sprinting")
+	TArray<FCustomSpeedTier> SpeedTiers;
+
+	static constexpr uint8 SpeedTierShift = 4;
+	static constexpr uint8 SpeedTierMask = 0xF0;
+	//As many tiers as the bits in SpeedTierMask can index.
+	static constexpr int32 MaxSpeedTiers = (SpeedTierMask >> SpeedTierShift) + 1;
+
+	/*
+	* Selects the speed tier used while sprinting. Call this on the owning client (or a listen server host), just like setting bWantsToSprint.
+	* Indices of MaxSpeedTiers and up don't fit in the flags, and are rejected rather than wrapped around to another tier.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Sprinting")
+	void SetSpeedTier(uint8 NewSpeedTier);
+
+	//Same as SetSpeedTier, but looks the tier up by name. Returns false if there is no tier with this name, or it is past MaxSpeedTiers.
+	UFUNCTION(BlueprintCallable, Category = "Sprinting")
+	bool SetSpeedTierByName(FName SpeedTierName);
+
+	UFUNCTION(BlueprintPure, Category = "Sprinting")
+	uint8 GetSpeedTier() const { return (MovementFlagCustom & SpeedTierMask) >> SpeedTierShift; }
+
+	/*
+	* The current maximum speed that the character can run, resolved from SpeedTiers.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Sprinting")
+	float GetCustomMaxSpeed() const;
 
 	/*
 	* A simple function to determine if the character is able to sprint in its current state.
@@ -246,6 +559,9 @@ public:
 	*/
 	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
 
+	//Only overridden to time each movement mode separately. See TutMovementStats.h.
+	virtual void StartNewPhysics(float deltaTime, int32 Iterations) override;
+
 	//Notice how this variable is declared. This allows BP to allow you to work with bit flags.
 	UPROPERTY(EditAnywhere, Category = TestBitflag, meta = (Bitmask, BitmaskEnum = "EMovementFlag"))
 	uint8 MovementFlagCustom = 0;
@@ -333,7 +649,8 @@ public:
 	* Fortunately, we can use a lot of the existing CMC code to help create our solution.
 	* This is far more than just a modifier, thus we create a movement mode.
 	*/
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Wall Running")
+	//Simulated proxies receive this inside ReplicatedMovementState.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Wall Running")
 	bool bWallRunIsRight;
 
 	// Wall Run Variables
@@ -345,6 +662,27 @@ public:
 	UPROPERTY(EditDefaultsOnly) float MinWallRunHeight = 50.f;
 	UPROPERTY(EditDefaultsOnly) UCurveFloat* WallRunGravityScaleCurve;
 	UPROPERTY(EditDefaultsOnly) float WallJumpForce = 300.f;
+	//After a probe finds no wall, TryWallRun waits this long (in simulated time) before tracing again. Falling crowds trace far less often.
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.0")) float WallRunProbeCooldown = 0.1f;
+
+	//Time left before TryWallRun is allowed to trace again. Tracked by our saved moves.
+	float WallRunProbeCooldownRemaining = 0.f;
+
+	/*
+	* Server only. Probe wall candidacy with an async overlap issued one frame ahead, and skip the synchronous probes when it proves there is no wall.
+	* Clients, and any move being replayed, always use the synchronous probes. See FTutAsyncWallProbe for why this can't cause a desync.
+	*/
+	UPROPERTY(EditDefaultsOnly) bool bUseAsyncWallProbes = false;
+	//Extra radius added to the async overlap to absorb the difference between our predicted and actual location.
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.0", EditCondition = "bUseAsyncWallProbes")) float AsyncWallProbeMargin = 25.f;
+	/*
+	* While wall running, the wall hit is reused until we move this far from where it was traced. See FTutWallContactCache.
+	* The distance is this many sub-steps of travel at our current speed: at 1.5, every other sub-step traces at any speed and frame rate.
+	* 0 traces every sub-step. Moves replayed after a correction always trace every sub-step.
+	*/
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.0")) float WallContactCacheSteps = 1.5f;
+	//Lower bound for the distance above, so a slow wall run doesn't trace every sub-step. Only used while WallContactCacheSteps is above 0.
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.0", EditCondition = "WallContactCacheSteps > 0")) float WallContactCacheThreshold = 10.f;
 	
 	
 	UFUNCTION(BlueprintPure) bool IsWallRunning() const { return IsCustomMovementMode(MOVE_WallRunning); }
@@ -372,6 +710,43 @@ protected:
 	*/
 	virtual void PhysWallRun(float deltaTime, int32 Iterations);
 
+	float GetMaxWallRunSpeed() const { return MaxWallRunSpeed; }
+
+	//WallRunGravityScaleCurve at TangentAccel, from the baked table when there is one. 0 without a curve.
+	float GetWallRunGravityScale(float TangentAccel) const;
+
+	//How far the wall contact cache may reuse its hit, for a sub-step of TimeStep at our current velocity.
+	float GetWallContactCacheThreshold(float TimeStep) const;
+
+	//WallRunGravityScaleCurve baked at BeginPlay, over the -1 to 1 range PhysWallRun samples. Shared with every component using the same curve.
+	TSharedPtr<const FTutCurveLUT> WallRunGravityScaleLUT;
+
+	//Whether TryWallRun may use AsyncWallProbe this move.
+	bool CanUseAsyncWallProbe() const;
+
+public:
+	//Checked by TryWallRun once the cheap checks pass, right before it probes. Lets subclasses rule out a wall run without any traces.
+	virtual bool MayProbeForWallRun() { return true; }
+
+	//The probe TryWallRun would issue from where we are right now.
+	FTutWallProbeQuery MakeWallProbeQuery() const;
+
+	//Whether TryWallRun's probe cooldown will have run out by the next move, DeltaSeconds from now.
+	bool IsWallProbeDue(float DeltaSeconds) const { return WallRunProbeCooldownRemaining - DeltaSeconds <= 0.f; }
+
+	//True if neither the level's wall run surface index nor any collision it doesn't cover is within reach of Query, so the side traces can't find a wall. False without an index.
+	bool IsWallRunRuledOutBySurfaceIndex(const FTutWallProbeQuery& Query) const;
+
+protected:
+
+	//Where the level's wall run surface index comes from, if it has one. See UTutWallRunSurfaceIndex.
+	UPROPERTY(Transient)
+	TObjectPtr<class UTutWallRunSurfaceSubsystem> WallRunSurfaces;
+
+	FTutAsyncWallProbe AsyncWallProbe;
+
+	FTutWallContactCache WallContactCache;
+
 	/*
 	* Here we have our ENTER/EXIT functions for the wall running movement mode.
 	*/
@@ -402,6 +777,11 @@ public:
 	virtual void BeginPlay() override;
 	//END UActorComponent Interface
 
+#if WITH_EDITOR
+	//Keeps SpeedTiers within MaxSpeedTiers.
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	//BEGIN UMovementComponent Interface
 	virtual float GetMaxSpeed() const override;
 
@@ -422,6 +802,19 @@ public:
 	//Replication. Boilerplate function that handles replicated variables. 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/*
+	* Everything simulated proxies need to know about our custom state, in one byte. Only the server writes it, see UpdateReplicatedMovementState.
+	* Replicating it as one property means one comparison per replication pass instead of one per bool, and the values always arrive together.
+	*/
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedMovementState)
+	FTutReplicatedMovementState ReplicatedMovementState;
+
+	UFUNCTION()
+	void OnRep_ReplicatedMovementState();
+
+	//Packs our current state into ReplicatedMovementState, and marks it dirty for push model replication when it changed. Called on the server after every move.
+	void UpdateReplicatedMovementState();
+
 protected:
 	/** Called after MovementMode has changed. Base implementation performs special handling for starting certain modes, then notifies the CharacterOwner. 
 	*	We update it to become our central movement mode switching function. All enter/exit functions should be stored here or in SetMovementMode.
@@ -435,14 +828,254 @@ public:
 	//New Move Data Container
 	FCustomCharacterNetworkMoveDataContainer MoveDataContainer;
 
+	//Per-field precision for the custom move data. Must match between client and server, so only edit the defaults.
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	FCustomMoveDataQuantization MoveDataQuantization;
+
+	//Delta encode the custom move data against previous moves. See FCustomCharacterNetworkMoveDataContainer::Serialize.
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	bool bDeltaEncodeMoveData = false;
+
+	//Good moves become the delta baseline for the moves we send next.
+	virtual void ClientAckGoodMove_Implementation(float TimeStamp) override;
+
+	//Counts what every ServerMovePacked we send costs, for the net soak. Owning client only.
+	virtual void ServerMovePacked_ClientSend(const FCharacterServerMovePackedBits& PackedBits) override;
+
+	uint32 NumServerMovesSent = 0;
+	uint64 NumServerMoveBitsSent = 0;
+
+	//New Move Response Data Container
+	FCustomCharacterMoveResponseDataContainer MoveResponseDataContainer;
+
+	//Corrections this character has been sent (server) or has applied (owning client). Counted in every build, for the net soak harness.
+	uint32 NumServerCorrections = 0;
+	uint32 NumClientCorrections = 0;
+
+	//Keeps the player's current input intact across the replay, just like the parent does for jumping and crouching.
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+
+	//Same check as the parent. When tut.Movement.CorrectionTelemetry is on, each correction is also recorded. See TutCorrectionTelemetry.h.
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+protected:
+
+	//Applies the custom state carried by a correction before our saved moves are replayed on top of it.
+	virtual void ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse) override;
+
+	//The MoveId given to the next saved move we set up.
+	uint32 NextSavedMoveId = 1;
+
+	//True from applying a correction until its replay is done. Saved moves leave our derived state alone meanwhile, as the server's values are the correct ones.
+	bool bReplayingCorrection = false;
+
+	//World time of the last movement mode change and the last applied launch. Only used for correction telemetry.
+	float LastModeChangeTime = 0.f;
+	float LastLaunchTime = -1.f;
+
+public:
+
 	virtual void UpdateFromCompressedFlags(uint8 Flags) override;	
 	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
 
 
 	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
 
+	//Adds the client prediction data, if we have any, so "obj list" and memreport count it against us.
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	//The counters of our saved move pool, or null while we have no client prediction data. Never allocates it.
+	virtual const FCustomSavedMovePool::FCounters* GetSavedMovePoolCounters() const;
+
+protected:
+
+	//Heap memory behind ClientPredictionData, which must already exist.
+	virtual SIZE_T GetClientPredictionDataSize() const;
+
+public:
+
 #pragma endregion
 /////END Networked Movement/////
+
+#pragma region Simulated Proxy LOD
+	/*
+	* Other players' characters on our client only ever play back what the server sends them, but a full component tick still
+	* extrapolates, sweeps, smooths the mesh and fires movement mode events for each of them, every frame.
+	* Proxies far away from every local player's view, or not rendered recently, drop to a cheaper ETutProxyLOD tier:
+	* beyond ProxyLODReducedDistance they tick at ProxyLODReducedTickInterval, beyond ProxyLODFrozenDistance they aren't simulated at all.
+	* Not being rendered drops a proxy one more tier, unless the client can't render at all (-nullrhi). A tier is only raised again once the proxy is ProxyLODHysteresis closer than the distance that dropped it.
+	* Off by default, as it changes what other players' characters look like at a distance. Turn it on per character class, and "tut.Movement.ProxyLOD 0" turns it off again, to compare against "stat TutMovement".
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD")
+	bool bEnableSimulatedProxyLOD = false;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD", meta = (ClampMin = "0.0"))
+	float ProxyLODReducedDistance = 3000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD", meta = (ClampMin = "0.0"))
+	float ProxyLODFrozenDistance = 8000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD", meta = (ClampMin = "0.0"))
+	float ProxyLODReducedTickInterval = 1.f / 15.f;
+
+	//How often each proxy picks its tier. Also how often a frozen proxy ticks at all.
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD", meta = (ClampMin = "0.01"))
+	float ProxyLODUpdateInterval = 0.25f;
+
+	//Seconds since the proxy was last rendered before it counts as not visible.
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD", meta = (ClampMin = "0.0"))
+	float ProxyLODRenderedTolerance = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Simulated Proxy LOD", meta = (ClampMin = "0.0", ClampMax = "0.5"))
+	float ProxyLODHysteresis = 0.1f;
+
+	UFUNCTION(BlueprintPure, Category = "Simulated Proxy LOD")
+	ETutProxyLOD GetProxyLOD() const { return ProxyLOD; }
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+
+	ETutProxyLOD ComputeProxyLOD() const;
+	void SetProxyLOD(ETutProxyLOD NewLOD);
+
+	//Enter and exit events for a movement mode. OnMovementModeChanged calls these, unless the proxy is frozen.
+	void CallMovementModeExit(EMovementMode Mode, uint8 CustomMode);
+	void CallMovementModeEnter(EMovementMode Mode, uint8 CustomMode);
+
+	/*
+	* Every mode's Phys, MaxSpeed, Enter and Exit functions, looked up by mode byte instead of a switch in each function.
+	* Custom modes are indexed by CustomMovementMode, the engine's modes by MovementMode. Both tables are filled in at the top of the .cpp,
+	* so adding a mode is one Register call there.
+	*/
+	using FModeHandlers = TTutMovementModeHandlers<UTutCharacterMovementComponent>;
+	using FCustomModeRegistry = TTutMovementModeRegistry<UTutCharacterMovementComponent, MOVE_CustomMAX>;
+	using FStandardModeRegistry = TTutMovementModeRegistry<UTutCharacterMovementComponent, MOVE_MAX>;
+
+	static const FCustomModeRegistry CustomModes;
+	static const FStandardModeRegistry StandardModes;
+
+	static const FModeHandlers& FindModeHandlers(EMovementMode Mode, uint8 CustomMode)
+	{
+		return Mode == MOVE_Custom ? CustomModes.Find(CustomMode) : StandardModes.Find(Mode);
+	}
+
+private:
+
+	ETutProxyLOD ProxyLOD = ETutProxyLOD::Full;
+	//Whether ProxyLOD applies to us, which is only known once we tick as a simulated proxy.
+	bool bProxyLODActive = false;
+	float ProxyLODTimeUntilUpdate = 0.f;
+	//The smoothing mode we were set up with, restored when leaving the frozen tier.
+	ENetworkSmoothingMode FullLODSmoothingMode = ENetworkSmoothingMode::Exponential;
+
+	//While frozen, the mode whose enter event fired last. The events catch up to the current mode once the proxy unfreezes.
+	bool bModeEventsDeferred = false;
+	TEnumAsByte<EMovementMode> DeferredEventMode = MOVE_None;
+	uint8 DeferredEventCustomMode = 0;
+
+public:
+
+#pragma endregion
+
+#pragma region Input Recording
+	/*
+	* Records the input feeding each of our moves, or feeds a recording back in place of the player's input. See TutMovementRecording.h.
+	* Both happen in ControlledCharacterMove, so only characters that run their own moves (owning clients, listen server hosts, standalone) can be recorded.
+	*/
+	void StartInputRecording(const FString& Name = FString());
+
+	//Saves the recording, with the current state as its end state. Returns the recording, or null if we weren't recording.
+	TSharedPtr<FTutMovementRecording> StopInputRecording();
+
+	bool IsRecordingInput() const { return InputRecording.IsValid(); }
+
+	//Starts feeding the recorded frames, one per move. Tick with each frame's DeltaSeconds to reproduce the session.
+	void StartInputReplay(TSharedPtr<const FTutMovementRecording> Recording);
+
+	bool IsReplayingInput() const { return InputReplay.IsValid() && InputReplayFrame < InputReplay->Frames.Num(); }
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+protected:
+
+	virtual void ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds) override;
+
+private:
+
+	TSharedPtr<FTutMovementRecording> InputRecording;
+	FString InputRecordingFilename;
+
+	TSharedPtr<const FTutMovementRecording> InputReplay;
+	int32 InputReplayFrame = 0;
+
+	//-TutRecordInput starts a recording on our first controlled move.
+	bool bCheckedAutoRecord = false;
+
+#pragma endregion
+
+#pragma region Movement Manager
+public:
+	/*
+	* Hand our tick to UTutMovementManagerSubsystem, which works out the sprint and wall run gates for every managed character in one batch.
+	* Only takes effect for characters the server moves itself (AI, bots). Player-controlled characters always tick on their own.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Movement Manager")
+	bool bUseMovementManager = false;
+
+	//CanSprint's threshold: how closely velocity has to follow the character's facing. Shared with the batched gates.
+	static constexpr float SprintForwardDot = 0.7f;
+
+	//Bits of a batched gate result.
+	static constexpr uint8 BatchedGateSprint = 1 << 0;
+	static constexpr uint8 BatchedGateWallRun = 1 << 1;
+
+	//We have authority and nobody is predicting our moves, so each tick runs exactly one move from the state the manager gathered.
+	bool CanUseMovementManager() const;
+
+	/*
+	* False when something is about to change our velocity before UpdateCharacterStateBeforeMovement, like a pending launch or impulse,
+	* or when the batched gates aren't ours to begin with (see UsesBaseMovementGates).
+	*/
+	bool CanUseBatchedGates() const;
+
+	/*
+	* Whether FTutMovementGateBatch::ComputeGates, which copies CanSprint and the early outs of TryWallRun, gives the answers we would.
+	* Only this class vouches for itself: a native subclass may override either, so it checks them itself unless it overrides this as well.
+	*/
+	virtual bool UsesBaseMovementGates() const;
+
+	//Called by AMyCustomCharacter whenever its controller changes. The movement manager has to tick us after the new one.
+	virtual void OnControllerChanged();
+
+	//Used by the next UpdateCharacterStateBeforeMovement in place of CanSprint and TryWallRun's early outs, then forgotten.
+	void SetBatchedGates(uint8 Gates) { BatchedGates = Gates; bHasBatchedGates = true; }
+
+	//A wall probe already run for Query. The next TryWallRun uses it instead of tracing, as long as it would have probed with the same query.
+	void SetPrecomputedWallProbe(const FTutWallProbeQuery& Query, const FTutWallProbeResult& Result);
+
+protected:
+
+	//True if we are NativeClass, or a Blueprint based on it.
+	bool IsOfNativeClass(const UClass* NativeClass) const;
+
+private:
+
+	friend class UTutMovementManagerSubsystem;
+
+	bool bManagedByMovementManager = false;
+
+	//The controller the manager's tick currently waits for on our behalf.
+	TWeakObjectPtr<AController> ManagerTickController;
+
+	uint8 BatchedGates = 0;
+	bool bHasBatchedGates = false;
+
+	FTutWallProbeQuery PrecomputedWallProbeQuery;
+	FTutWallProbeResult PrecomputedWallProbe;
+	bool bHasPrecomputedWallProbe = false;
+
+#pragma endregion
 };
 
 #pragma endregion
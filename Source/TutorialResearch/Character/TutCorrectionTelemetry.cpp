@@ -0,0 +1,186 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutCorrectionTelemetry.h"
+#include "TutCharacterMovementComponent.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+static int32 GTutCorrectionTelemetry = 0;
+static FAutoConsoleVariableRef CVarTutCorrectionTelemetry(
+	TEXT("tut.Movement.CorrectionTelemetry"),
+	GTutCorrectionTelemetry,
+	TEXT("Record server corrections of our custom movement to Saved/Profiling/TutCorrections-*.csv and a per-mode histogram.\n")
+	TEXT("0: off, 1: on"),
+	FConsoleVariableDelegate::CreateLambda([](IConsoleVariable*)
+	{
+		if (!GTutCorrectionTelemetry)
+		{
+			FTutCorrectionTelemetry::Get().Close();
+		}
+	}));
+
+static FAutoConsoleCommand CmdTutCorrectionHistogram(
+	TEXT("tut.Movement.CorrectionHistogram"),
+	TEXT("Logs the correction histogram per movement mode. Pass 'reset' to clear it."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			FTutCorrectionTelemetry::Get().ResetHistogram();
+			return;
+		}
+		FTutCorrectionTelemetry::Get().LogHistogram();
+	}));
+
+const TCHAR* TutCorrectionSuspect::GetName(ETutCorrectionSuspect Suspect)
+{
+	switch (Suspect)
+	{
+	case ETutCorrectionSuspect::Mode:		return TEXT("Mode");
+	case ETutCorrectionSuspect::Flags:		return TEXT("Flags");
+	case ETutCorrectionSuspect::Sprint:		return TEXT("Sprint");
+	case ETutCorrectionSuspect::WallRun:	return TEXT("WallRun");
+	case ETutCorrectionSuspect::Launch:		return TEXT("Launch");
+	case ETutCorrectionSuspect::Fly:		return TEXT("Fly");
+	default:								return TEXT("Unknown");
+	}
+}
+
+bool TutCorrectionSuspect::IsHeuristic(ETutCorrectionSuspect Suspect)
+{
+	return Suspect != ETutCorrectionSuspect::Mode && Suspect != ETutCorrectionSuspect::Flags;
+}
+
+const float FTutCorrectionTelemetry::ErrorBucketLimits[NumErrorBuckets - 1] = { 1.f, 5.f, 10.f, 25.f, 50.f, 100.f };
+
+FTutCorrectionTelemetry& FTutCorrectionTelemetry::Get()
+{
+	static FTutCorrectionTelemetry Instance;
+	return Instance;
+}
+
+bool FTutCorrectionTelemetry::IsEnabled()
+{
+	return GTutCorrectionTelemetry != 0;
+}
+
+FTutCorrectionTelemetry::FTutCorrectionTelemetry()
+{
+	//Static destruction is too late to rely on the file system, so close the file while the engine is still around.
+	FCoreDelegates::OnPreExit.AddRaw(this, &FTutCorrectionTelemetry::Close);
+}
+
+FTutCorrectionTelemetry::~FTutCorrectionTelemetry()
+{
+	Close();
+}
+
+void FTutCorrectionTelemetry::Record(const FTutCorrectionRecord& Record)
+{
+	FModeHistogram& Histogram = Histograms.FindOrAdd((uint16(Record.ServerMode) << 8) | Record.ServerCustomMode);
+	int32 Bucket = 0;
+	while (Bucket < NumErrorBuckets - 1 && Record.PositionError >= ErrorBucketLimits[Bucket])
+	{
+		++Bucket;
+	}
+	++Histogram.ErrorBuckets[Bucket];
+	++Histogram.Total;
+	for (int32 Suspect = 0; Suspect < (int32)ETutCorrectionSuspect::Num; ++Suspect)
+	{
+		Histogram.SuspectCounts[Suspect] += Record.HasSuspect((ETutCorrectionSuspect)Suspect);
+	}
+
+	if (!CsvWriter)
+	{
+		const FString Filename = FPaths::ProfilingDir() / FString::Printf(TEXT("TutCorrections-%s.csv"), *FDateTime::Now().ToString());
+		CsvWriter.Reset(IFileManager::Get().CreateFileWriter(*Filename, FILEWRITE_AllowRead));
+		if (!CsvWriter)
+		{
+			return;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Writing correction telemetry to %s"), *Filename);
+		FString Header = TEXT("WorldTime,Frame,Character,ServerMode,ClientMode,PositionError");
+		for (int32 Suspect = 0; Suspect < (int32)ETutCorrectionSuspect::Num; ++Suspect)
+		{
+			Header += FString::Printf(TEXT(",%s"), TutCorrectionSuspect::GetName((ETutCorrectionSuspect)Suspect));
+		}
+		Header += TEXT(",TimeSinceModeChange,InBytesPerSecond,OutBytesPerSecond");
+		WriteLine(Header);
+	}
+
+	FString Line = FString::Printf(TEXT("%.3f,%llu,%s,%s,%s,%.2f"),
+		Record.WorldTime, Record.Frame, *Record.CharacterName,
+		*GetModeName(Record.ServerMode, Record.ServerCustomMode), *GetModeName(Record.ClientMode, Record.ClientCustomMode),
+		Record.PositionError);
+	for (int32 Suspect = 0; Suspect < (int32)ETutCorrectionSuspect::Num; ++Suspect)
+	{
+		Line += Record.HasSuspect((ETutCorrectionSuspect)Suspect) ? TEXT(",1") : TEXT(",0");
+	}
+	Line += FString::Printf(TEXT(",%.3f,%d,%d"), Record.TimeSinceModeChange, Record.InBytesPerSecond, Record.OutBytesPerSecond);
+	WriteLine(Line);
+}
+
+void FTutCorrectionTelemetry::WriteLine(const FString& Line)
+{
+	const FTCHARToUTF8 Utf8(*(Line + LINE_TERMINATOR));
+	CsvWriter->Serialize((void*)Utf8.Get(), Utf8.Length());
+
+	//Flush regularly so the file can be followed while the server runs, without paying for a flush on every correction.
+	if (++UnflushedLines >= 32)
+	{
+		CsvWriter->Flush();
+		UnflushedLines = 0;
+	}
+}
+
+void FTutCorrectionTelemetry::Close()
+{
+	if (CsvWriter)
+	{
+		CsvWriter->Close();
+		CsvWriter.Reset();
+		UnflushedLines = 0;
+	}
+}
+
+void FTutCorrectionTelemetry::LogHistogram() const
+{
+	FString SuspectNames;
+	for (int32 Suspect = 0; Suspect < (int32)ETutCorrectionSuspect::Num; ++Suspect)
+	{
+		SuspectNames += FString::Printf(TEXT(" %s%s"), TutCorrectionSuspect::IsHeuristic((ETutCorrectionSuspect)Suspect) ? TEXT("~") : TEXT(""), TutCorrectionSuspect::GetName((ETutCorrectionSuspect)Suspect));
+	}
+	UE_LOG(LogTemp, Display, TEXT("Correction histogram (position error in cm): <1 | <5 | <10 | <25 | <50 | <100 | >=100 || suspects (~ is a heuristic):%s"), *SuspectNames);
+
+	for (const TPair<uint16, FModeHistogram>& Pair : Histograms)
+	{
+		const FModeHistogram& Histogram = Pair.Value;
+		FString SuspectCounts;
+		for (const uint32 Count : Histogram.SuspectCounts)
+		{
+			SuspectCounts += FString::Printf(TEXT(" %u"), Count);
+		}
+		UE_LOG(LogTemp, Display, TEXT("%-14s %6u: %u | %u | %u | %u | %u | %u | %u ||%s"),
+			*GetModeName(Pair.Key >> 8, Pair.Key & 0xFF), Histogram.Total,
+			Histogram.ErrorBuckets[0], Histogram.ErrorBuckets[1], Histogram.ErrorBuckets[2], Histogram.ErrorBuckets[3],
+			Histogram.ErrorBuckets[4], Histogram.ErrorBuckets[5], Histogram.ErrorBuckets[6],
+			*SuspectCounts);
+	}
+}
+
+void FTutCorrectionTelemetry::ResetHistogram()
+{
+	Histograms.Reset();
+}
+
+FString FTutCorrectionTelemetry::GetModeName(uint8 Mode, uint8 CustomMode)
+{
+	if (Mode == MOVE_Custom)
+	{
+		return StaticEnum<ECustomMovementMode>()->GetNameStringByValue(CustomMode);
+	}
+	return StaticEnum<EMovementMode>()->GetNameStringByValue(Mode);
+}
@@ -0,0 +1,115 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* Which of our custom features may have caused a correction, as bit indices into FTutCorrectionRecord::Suspects.
+* The server only has its own state and what the client sent with the move, so only some of these are actual disagreements between the two.
+* The rest are heuristics: they say one of our features was in play, which makes it a lead, not proof. IsHeuristic tells them apart.
+* The CSV columns and the histogram follow this enum, so a new suspect only needs an entry here and in GetName.
+*/
+enum class ETutCorrectionSuspect : uint8
+{
+	//The movement mode the client sent with the move differs from the server's.
+	Mode,
+	//The custom flags the client sent (speed tier, fly) differ from the server's after the move, i.e. what FCustomMoveResponseData corrects them to.
+	Flags,
+	//Heuristic. The client wanted to sprint but the server's CanSprint said no. The client's own CanSprint isn't sent, so it may have said no too.
+	Sprint,
+	//Heuristic. Both sides were wall running. Mode agrees, but the wall side and the distance to the wall aren't sent, so they may not.
+	WallRun,
+	//Heuristic. A launch was sent with this move, is pending, or was applied recently.
+	Launch,
+	//Heuristic. The fly flag doesn't match whether the server is flying.
+	Fly,
+
+	Num
+};
+
+namespace TutCorrectionSuspect
+{
+	TUTORIALRESEARCH_API const TCHAR* GetName(ETutCorrectionSuspect Suspect);
+	TUTORIALRESEARCH_API bool IsHeuristic(ETutCorrectionSuspect Suspect);
+	constexpr uint32 ToBit(ETutCorrectionSuspect Suspect) { return 1u << uint32(Suspect); }
+}
+
+struct FTutCorrectionRecord
+{
+	double WorldTime = 0.0;
+	uint64 Frame = 0;
+	FString CharacterName;
+
+	uint8 ServerMode = 0;
+	uint8 ServerCustomMode = 0;
+	uint8 ClientMode = 0;
+	uint8 ClientCustomMode = 0;
+
+	//Distance between where the client said it was and where the server has it.
+	float PositionError = 0.f;
+
+	//One bit per ETutCorrectionSuspect.
+	uint32 Suspects = 0;
+
+	void AddSuspect(ETutCorrectionSuspect Suspect) { Suspects |= TutCorrectionSuspect::ToBit(Suspect); }
+	bool HasSuspect(ETutCorrectionSuspect Suspect) const { return (Suspects & TutCorrectionSuspect::ToBit(Suspect)) != 0; }
+
+	//Since the server's last movement mode change. Corrections right after a transition point at the transition.
+	float TimeSinceModeChange = 0.f;
+
+	//From the owning connection, so corrections can be lined up against bandwidth.
+	int32 InBytesPerSecond = 0;
+	int32 OutBytesPerSecond = 0;
+};
+
+/*
+* Server-side correction telemetry for the custom movement modes.
+* Enable with "tut.Movement.CorrectionTelemetry 1" (or -ExecCmds on a headless server). Every correction is then streamed to
+* Saved/Profiling/TutCorrections-<timestamp>.csv, and counted in a histogram of error size per movement mode.
+* Heuristic suspects (see ETutCorrectionSuspect) are marked with a ~ in the histogram.
+* "tut.Movement.CorrectionHistogram" prints the histogram to the log, "tut.Movement.CorrectionHistogram reset" clears it.
+* Game thread only.
+*/
+class TUTORIALRESEARCH_API FTutCorrectionTelemetry
+{
+public:
+
+	static FTutCorrectionTelemetry& Get();
+
+	static bool IsEnabled();
+
+	void Record(const FTutCorrectionRecord& Record);
+
+	void LogHistogram() const;
+	void ResetHistogram();
+
+	//Writes out anything still buffered and closes the file. The next record opens a new one.
+	void Close();
+
+	~FTutCorrectionTelemetry();
+
+private:
+
+	FTutCorrectionTelemetry();
+
+	//Upper bounds in cm. The last bucket catches everything above.
+	static constexpr int32 NumErrorBuckets = 7;
+	static const float ErrorBucketLimits[NumErrorBuckets - 1];
+
+	struct FModeHistogram
+	{
+		uint32 ErrorBuckets[NumErrorBuckets] = {};
+		uint32 SuspectCounts[(int32)ETutCorrectionSuspect::Num] = {};
+		uint32 Total = 0;
+	};
+
+	//Keyed by server movement mode in the high byte and custom mode in the low byte.
+	TMap<uint16, FModeHistogram> Histograms;
+
+	TUniquePtr<FArchive> CsvWriter;
+	int32 UnflushedLines = 0;
+
+	static FString GetModeName(uint8 Mode, uint8 CustomMode);
+	void WriteLine(const FString& Line);
+};
@@ -0,0 +1,123 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutCurveLUT.h"
+#include "Curves/CurveFloat.h"
+#include "Math/RandomStream.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/Package.h"
+
+FTutCurveLUT::FTutCurveLUT(const UCurveFloat& Curve, float InMinTime, float InMaxTime)
+	: MinTime(InMinTime)
+	, MaxTime(FMath::Max(InMaxTime, InMinTime + UE_KINDA_SMALL_NUMBER))
+	, Source(&Curve)
+{
+	const float Step = (MaxTime - MinTime) / (NumSamples - 1);
+	SamplesPerTime = 1.f / Step;
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		Samples[Index] = Curve.GetFloatValue(MinTime + Step * Index);
+	}
+}
+
+TSharedPtr<const FTutCurveLUT> FTutCurveLUT::FindOrBake(const UCurveFloat* Curve, float MinTime, float MaxTime)
+{
+	check(IsInGameThread());
+	if (!Curve)
+	{
+		return nullptr;
+	}
+
+	//Weak, so a table goes away with the last component using it, and a curve edited between play sessions gets baked again.
+	using FKey = TTuple<TObjectKey<UCurveFloat>, float, float>;
+	static TMap<FKey, TWeakPtr<const FTutCurveLUT>> SharedTables;
+
+	TWeakPtr<const FTutCurveLUT>& Shared = SharedTables.FindOrAdd(FKey(Curve, MinTime, MaxTime));
+	TSharedPtr<const FTutCurveLUT> Table = Shared.Pin();
+	if (!Table)
+	{
+		Table = MakeShared<FTutCurveLUT>(*Curve, MinTime, MaxTime);
+		Shared = Table;
+	}
+	return Table;
+}
+
+namespace TutCurveLUT
+{
+	//Shaped like a wall run gravity scale curve: light while pushing along the wall, heavier when letting go or pushing back.
+	static UCurveFloat* MakeTestCurve()
+	{
+		UCurveFloat* Curve = NewObject<UCurveFloat>(GetTransientPackage());
+		for (const FVector2D& Key : { FVector2D(-1.f, 1.f), FVector2D(-0.25f, 0.8f), FVector2D(0.f, 0.5f), FVector2D(0.6f, 0.2f), FVector2D(1.f, 0.1f) })
+		{
+			Curve->FloatCurve.SetKeyInterpMode(Curve->FloatCurve.AddKey(Key.X, Key.Y), RCIM_Cubic);
+		}
+		Curve->FloatCurve.AutoSetTangents();
+		return Curve;
+	}
+
+	static void RunBenchmark(const TArray<FString>& Args)
+	{
+		const UCurveFloat* Curve = Args.Num() > 0 ? LoadObject<UCurveFloat>(nullptr, *Args[0]) : MakeTestCurve();
+		if (!Curve)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("tut.Movement.BenchmarkCurveLUT: couldn't load curve '%s'."), *Args[0]);
+			return;
+		}
+		const int32 NumEvaluations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000000;
+
+		//The range PhysWallRun samples over.
+		const FTutCurveLUT Table(*Curve, -1.f, 1.f);
+
+		FRandomStream Random(1337);
+		TArray<float> Times;
+		Times.SetNumUninitialized(NumEvaluations);
+		for (float& Time : Times)
+		{
+			Time = Random.FRandRange(-1.f, 1.f);
+		}
+
+		//Each is run twice and the second run timed, so neither pays for a cold cache. The sums keep the loops from being optimised away.
+		double CurveSum = 0.0;
+		double CurveSeconds = 0.0;
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			CurveSum = 0.0;
+			const double StartSeconds = FPlatformTime::Seconds();
+			for (const float Time : Times)
+			{
+				CurveSum += Curve->GetFloatValue(Time);
+			}
+			CurveSeconds = FPlatformTime::Seconds() - StartSeconds;
+		}
+
+		double TableSum = 0.0;
+		double TableSeconds = 0.0;
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			TableSum = 0.0;
+			const double StartSeconds = FPlatformTime::Seconds();
+			for (const float Time : Times)
+			{
+				TableSum += Table.Evaluate(Time);
+			}
+			TableSeconds = FPlatformTime::Seconds() - StartSeconds;
+		}
+
+		float MaxError = 0.f;
+		for (const float Time : Times)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(Curve->GetFloatValue(Time) - Table.Evaluate(Time)));
+		}
+
+		const double NanosecondsPerEvaluation = 1.0e9 / NumEvaluations;
+		UE_LOG(LogTemp, Display, TEXT("TutCurveLUTBenchmark Evaluations=%d Samples=%d CurveNs=%.2f LUTNs=%.2f Speedup=%.1f MaxError=%.6f CurveSum=%.3f LUTSum=%.3f"),
+			NumEvaluations, FTutCurveLUT::NumSamples, CurveSeconds * NanosecondsPerEvaluation, TableSeconds * NanosecondsPerEvaluation,
+			TableSeconds > 0.0 ? CurveSeconds / TableSeconds : 0.0, MaxError, CurveSum, TableSum);
+	}
+}
+
+static FAutoConsoleCommand CmdTutBenchmarkCurveLUT(
+	TEXT("tut.Movement.BenchmarkCurveLUT"),
+	TEXT("Times UCurveFloat::GetFloatValue against FTutCurveLUT::Evaluate over the same inputs, and reports the largest difference between them. ")
+	TEXT("Optional arguments: a curve asset path (a built-in curve otherwise), and the number of evaluations (a million by default)."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TutCurveLUT::RunBenchmark));
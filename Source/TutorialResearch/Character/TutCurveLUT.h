@@ -0,0 +1,54 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class UCurveFloat;
+
+/*
+* A float curve baked into a fixed number of evenly spaced samples, for curves evaluated in the movement hot path.
+*
+* UCurveFloat::GetFloatValue searches the curve's keys and follows a couple of pointers to get there, on every call.
+* PhysWallRun samples WallRunGravityScaleCurve on every sub-step of every wall running character, so that adds up.
+* Evaluate is a clamp, one multiply and a lerp between two neighbouring floats, and the whole table fits in a few cache lines.
+*
+* Between samples the curve is approximated linearly, so sharp corners and constant steps get smoothed over one sample step ((MaxTime - MinTime) / (NumSamples - 1)).
+* Outside [MinTime, MaxTime] the end samples are held. Only bake ranges the curve is actually evaluated over.
+*
+* Tables are shared: every component baking the same curve over the same range gets the same one (see FindOrBake).
+* The table is baked once, so edits to the curve asset made while playing only show up in components that bake after the edit.
+*/
+class TUTORIALRESEARCH_API FTutCurveLUT
+{
+public:
+
+	static constexpr int32 NumSamples = 256;
+
+	FTutCurveLUT(const UCurveFloat& Curve, float InMinTime, float InMaxTime);
+
+	//The shared table for Curve over [MinTime, MaxTime], baked on first use. Game thread only.
+	static TSharedPtr<const FTutCurveLUT> FindOrBake(const UCurveFloat* Curve, float MinTime, float MaxTime);
+
+	FORCEINLINE float Evaluate(float Time) const
+	{
+		const float Position = FMath::Clamp((Time - MinTime) * SamplesPerTime, 0.f, float(NumSamples - 1));
+		const int32 Index = FMath::Min(int32(Position), NumSamples - 2);
+		return FMath::Lerp(Samples[Index], Samples[Index + 1], Position - float(Index));
+	}
+
+	//The curve this was baked from. Only for telling whether a component's curve has been swapped since, never dereferenced.
+	const UCurveFloat* GetSource() const { return Source; }
+
+	float GetMinTime() const { return MinTime; }
+	float GetMaxTime() const { return MaxTime; }
+
+private:
+
+	float Samples[NumSamples];
+	float MinTime = 0.f;
+	float MaxTime = 1.f;
+	float SamplesPerTime = 0.f;
+	const UCurveFloat* Source = nullptr;
+};
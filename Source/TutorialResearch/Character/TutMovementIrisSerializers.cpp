@@ -0,0 +1,124 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutCharacterMovementComponent.h"
+
+#if UE_WITH_IRIS
+
+#include "Iris/Serialization/NetSerializer.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+#include "Iris/Serialization/NetBitStreamReader.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+
+/*
+* Iris serializers for the custom movement replication.
+*
+* Iris doesn't call NetSerialize on structs. Without a serializer of its own, FTutReplicatedMovementState would be replicated
+* by the default struct serializer as a full uint8, and every property of the component gets its replication fragment from the default
+* property fragment registration, which is all this component needs.
+*
+* The packed moves and move responses need nothing here: they go through the engine's FCharacterNetworkSerializationPackedBits serializer,
+* which still calls Serialize on our FCustomCharacterNetworkMoveDataContainer and FCustomCharacterMoveResponseDataContainer.
+*
+* Iris is switched on with net.Iris.UseIrisReplication=1 (see DefaultEngine.ini), on a build with bUseIris in its target (TUT_USE_IRIS=1, source engine only).
+*/
+namespace UE::Net
+{
+
+//Quantized to the packed byte, written with the same 7 bits as NetSerialize.
+struct FTutReplicatedMovementStateNetSerializer
+{
+	//Bump when the wire format changes.
+	static const uint32 Version = 0;
+
+	typedef FTutReplicatedMovementState SourceType;
+	typedef uint8 QuantizedType;
+	typedef FNetSerializerConfig ConfigType;
+
+	static const ConfigType DefaultConfig;
+
+	static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args);
+	static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args);
+
+	static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args);
+	static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args);
+
+	static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args);
+	static bool Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args);
+
+private:
+
+	//Registers the serializer for the struct's name once Iris builds its registry, so properties of this type use it.
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	static FTutReplicatedMovementStateNetSerializer::FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+};
+
+UE_NET_DECLARE_SERIALIZER(FTutReplicatedMovementStateNetSerializer, TUTORIALRESEARCH_API);
+UE_NET_IMPLEMENT_SERIALIZER(FTutReplicatedMovementStateNetSerializer);
+
+const FTutReplicatedMovementStateNetSerializer::ConfigType FTutReplicatedMovementStateNetSerializer::DefaultConfig;
+FTutReplicatedMovementStateNetSerializer::FNetSerializerRegistryDelegates FTutReplicatedMovementStateNetSerializer::NetSerializerRegistryDelegates;
+
+static const FName PropertyNetSerializerRegistry_NAME_TutReplicatedMovementState("TutReplicatedMovementState");
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TutReplicatedMovementState, FTutReplicatedMovementStateNetSerializer);
+
+void FTutReplicatedMovementStateNetSerializer::Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+{
+	const QuantizedType Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	Context.GetBitStreamWriter()->WriteBits(Value, FTutReplicatedMovementState::NumBits);
+}
+
+void FTutReplicatedMovementStateNetSerializer::Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+{
+	*reinterpret_cast<QuantizedType*>(Args.Target) = QuantizedType(Context.GetBitStreamReader()->ReadBits(FTutReplicatedMovementState::NumBits));
+}
+
+void FTutReplicatedMovementStateNetSerializer::Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+{
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+	*reinterpret_cast<QuantizedType*>(Args.Target) = Source.GetPacked();
+}
+
+void FTutReplicatedMovementStateNetSerializer::Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+{
+	const QuantizedType Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	*reinterpret_cast<SourceType*>(Args.Target) = SourceType::FromPacked(Value);
+}
+
+bool FTutReplicatedMovementStateNetSerializer::IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+{
+	if (Args.bStateIsQuantized)
+	{
+		return *reinterpret_cast<const QuantizedType*>(Args.Source0) == *reinterpret_cast<const QuantizedType*>(Args.Source1);
+	}
+
+	return *reinterpret_cast<const SourceType*>(Args.Source0) == *reinterpret_cast<const SourceType*>(Args.Source1);
+}
+
+bool FTutReplicatedMovementStateNetSerializer::Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args)
+{
+	//Anything above NumBits would be lost on the wire.
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+	return (Source.GetPacked() >> FTutReplicatedMovementState::NumBits) == 0;
+}
+
+FTutReplicatedMovementStateNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TutReplicatedMovementState);
+}
+
+void FTutReplicatedMovementStateNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TutReplicatedMovementState);
+}
+
+}
+
+#endif //UE_WITH_IRIS
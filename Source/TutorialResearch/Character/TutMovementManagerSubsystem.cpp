@@ -0,0 +1,358 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutMovementManagerSubsystem.h"
+#include "TutCharacterMovementComponent.h"
+#include "TutMovementStats.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Controller.h"
+#include "MyCustomCharacter.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+static bool GTutParallelWallProbes = false;
+static FAutoConsoleVariableRef CVarTutParallelWallProbes(
+	TEXT("tut.Movement.ParallelWallProbes"),
+	GTutParallelWallProbes,
+	TEXT("Run the wall probes of characters ticked by UTutMovementManagerSubsystem in parallel, before any of them move."));
+
+//Below this many probes, waking up workers costs more than the traces.
+static int32 GTutParallelWallProbesMinBatch = 16;
+static FAutoConsoleVariableRef CVarTutParallelWallProbesMinBatch(
+	TEXT("tut.Movement.ParallelWallProbesMinBatch"),
+	GTutParallelWallProbesMinBatch,
+	TEXT("The fewest wall probes worth spreading over worker threads. Smaller batches run on the game thread."));
+
+//How far another character may move between the batch and our turn in the serial pass. Characters within reach plus this are left to the serial probe.
+static float GTutParallelWallProbesPawnMargin = 100.f;
+static FAutoConsoleVariableRef CVarTutParallelWallProbesPawnMargin(
+	TEXT("tut.Movement.ParallelWallProbesPawnMargin"),
+	GTutParallelWallProbesPawnMargin,
+	TEXT("Parallel wall probes with a pawn this close to their reach are skipped, and traced by the character itself after the pawns before it have moved."));
+
+void FTutMovementManagerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Manager)
+	{
+		Manager->TickManaged(DeltaTime, TickType);
+	}
+}
+
+FString FTutMovementManagerTickFunction::DiagnosticMessage()
+{
+	return TEXT("FTutMovementManagerTickFunction");
+}
+
+#pragma region Gate Batch
+
+void FTutMovementGateBatch::SetNum(int32 NewNum)
+{
+	VelocityX.SetNum(NewNum, false);
+	VelocityY.SetNum(NewNum, false);
+	VelocityZ.SetNum(NewNum, false);
+	ForwardX.SetNum(NewNum, false);
+	ForwardY.SetNum(NewNum, false);
+	ForwardZ.SetNum(NewNum, false);
+	MinWallRunSpeedSquared.SetNum(NewNum, false);
+	MaxVerticalWallRunSpeed.SetNum(NewNum, false);
+	MovementModes.SetNum(NewNum, false);
+	CustomMovementModes.SetNum(NewNum, false);
+	Flags.SetNum(NewNum, false);
+	Gates.SetNum(NewNum, false);
+}
+
+void FTutMovementGateBatch::Gather(int32 Index, const UTutCharacterMovementComponent& Movement)
+{
+	const FVector& Velocity = Movement.Velocity;
+	const FVector Forward = Movement.GetCharacterOwner()->GetActorForwardVector();
+
+	VelocityX[Index] = Velocity.X;
+	VelocityY[Index] = Velocity.Y;
+	VelocityZ[Index] = Velocity.Z;
+	ForwardX[Index] = Forward.X;
+	ForwardY[Index] = Forward.Y;
+	ForwardZ[Index] = Forward.Z;
+	MinWallRunSpeedSquared[Index] = FMath::Square(Movement.MinWallRunSpeed);
+	MaxVerticalWallRunSpeed[Index] = Movement.MaxVerticalWallRunSpeed;
+	MovementModes[Index] = Movement.MovementMode;
+	CustomMovementModes[Index] = Movement.CustomMovementMode;
+	Flags[Index] = (Movement.IsMovingOnGround() ? FlagMovingOnGround : 0)
+		| (Movement.bWantsToSprint ? FlagWantsToSprint : 0)
+		| (Movement.IsFalling() ? FlagFalling : 0);
+}
+
+bool FTutMovementGateBatch::IsStillCurrent(int32 Index, const UTutCharacterMovementComponent& Movement) const
+{
+	const FVector& Velocity = Movement.Velocity;
+	return float(Velocity.X) == VelocityX[Index] && float(Velocity.Y) == VelocityY[Index] && float(Velocity.Z) == VelocityZ[Index]
+		&& Movement.MovementMode == MovementModes[Index] && Movement.CustomMovementMode == CustomMovementModes[Index];
+}
+
+void FTutMovementGateBatch::ComputeGates()
+{
+	const int32 Count = Num();
+	constexpr uint8 SprintInputs = FlagMovingOnGround | FlagWantsToSprint;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const float VX = VelocityX[Index];
+		const float VY = VelocityY[Index];
+		const float VZ = VelocityZ[Index];
+		const float SizeSquared2D = VX * VX + VY * VY;
+		const float SizeSquared = SizeSquared2D + VZ * VZ;
+		const float ForwardDot = ForwardX[Index] * VX + ForwardY[Index] * VY + ForwardZ[Index] * VZ;
+		const uint8 InFlags = Flags[Index];
+
+		//CanSprint: Forward | Velocity.GetSafeNormal() > SprintForwardDot, with the normalize folded into the right hand side.
+		const uint8 bCanSprint = uint8((InFlags & SprintInputs) == SprintInputs)
+			& uint8(SizeSquared > UE_SMALL_NUMBER)
+			& uint8(ForwardDot > UTutCharacterMovementComponent::SprintForwardDot * FMath::Sqrt(SizeSquared));
+
+		//TryWallRun's early outs. The probe cooldown and the traces are still checked by TryWallRun itself.
+		const uint8 bMayWallRun = uint8((InFlags & FlagFalling) != 0)
+			& uint8(SizeSquared2D >= MinWallRunSpeedSquared[Index])
+			& uint8(VZ >= -MaxVerticalWallRunSpeed[Index]);
+
+		Gates[Index] = (bCanSprint * UTutCharacterMovementComponent::BatchedGateSprint) | (bMayWallRun * UTutCharacterMovementComponent::BatchedGateWallRun);
+	}
+}
+
+#pragma endregion
+
+#pragma region Wall Probe Batch
+
+void FTutWallProbeBatch::Reset(int32 NumSlots)
+{
+	Slots.Reset();
+	Queries.Reset();
+	Params.Reset();
+	ProbeForSlot.SetNum(NumSlots, false);
+	for (int32& Probe : ProbeForSlot)
+	{
+		Probe = INDEX_NONE;
+	}
+}
+
+void FTutWallProbeBatch::Add(int32 Slot, const FTutWallProbeQuery& Query, const FCollisionQueryParams& InParams)
+{
+	ProbeForSlot[Slot] = Queries.Num();
+	Slots.Add(Slot);
+	Queries.Add(Query);
+	Params.Add(&InParams);
+}
+
+void FTutWallProbeBatch::Run(const UWorld* World)
+{
+	Results.SetNum(Queries.Num(), false);
+	PawnNearby.SetNum(Queries.Num(), false);
+
+	const EParallelForFlags Flags = Queries.Num() < GTutParallelWallProbesMinBatch ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+	ParallelFor(Queries.Num(), [this, World](int32 Index)
+	{
+		//The probes hit pawns, which are still where they were last frame. If one is close enough to get in the way once it moves, don't guess.
+		const FTutWallProbeQuery& Query = Queries[Index];
+		const float Radius = FMath::Max(Query.SideDistance, Query.FloorDistance) + GTutParallelWallProbesPawnMargin;
+		PawnNearby[Index] = World->OverlapAnyTestByObjectType(Query.Start, FQuat::Identity, FCollisionObjectQueryParams(ECC_Pawn), FCollisionShape::MakeSphere(Radius), *Params[Index]);
+		if (!PawnNearby[Index])
+		{
+			FTutWallProbe::ProbeForWallRun(World, Query, *Params[Index], Results[Index]);
+		}
+	}, Flags);
+}
+
+#pragma endregion
+
+#pragma region Manager
+
+bool UTutMovementManagerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTutMovementManagerSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Manager = this;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UTutMovementManagerSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Manager = nullptr;
+
+	const TArray<TObjectPtr<UTutCharacterMovementComponent>> Managed = Components;
+	for (UTutCharacterMovementComponent* Movement : Managed)
+	{
+		Unregister(Movement);
+	}
+	Components.Reset();
+
+	Super::Deinitialize();
+}
+
+void UTutMovementManagerSubsystem::Register(UTutCharacterMovementComponent* Movement)
+{
+	if (!Movement || Movement->bManagedByMovementManager)
+	{
+		return;
+	}
+
+	Components.Add(Movement);
+	Movement->bManagedByMovementManager = true;
+	Movement->SetComponentTickEnabled(false);
+
+	UpdateControllerPrerequisite(Movement);
+	INC_DWORD_STAT(STAT_TutManagedCharacters);
+}
+
+void UTutMovementManagerSubsystem::Unregister(UTutCharacterMovementComponent* Movement)
+{
+	const int32 Index = Movement ? Components.Find(Movement) : INDEX_NONE;
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	//A character destroyed by another one's tick mustn't shift the slots we are dispatching. Its slot is cleared, and removed next frame.
+	if (bDispatching)
+	{
+		Components[Index] = nullptr;
+	}
+	else
+	{
+		Components.RemoveAtSwap(Index);
+	}
+
+	DEC_DWORD_STAT(STAT_TutManagedCharacters);
+	if (IsValid(Movement))
+	{
+		if (AController* Controller = Movement->ManagerTickController.Get())
+		{
+			TickFunction.RemovePrerequisite(Controller, Controller->PrimaryActorTick);
+		}
+		Movement->ManagerTickController = nullptr;
+		Movement->bManagedByMovementManager = false;
+		if (Movement->HasBegunPlay())
+		{
+			Movement->SetComponentTickEnabled(true);
+		}
+	}
+}
+
+void UTutMovementManagerSubsystem::UpdateControllerPrerequisite(UTutCharacterMovementComponent* Movement)
+{
+	//The controller's tick has to run first, same as it would for the component's own tick (see AController::AddPawnTickDependency).
+	AController* Controller = Movement->GetCharacterOwner() ? Movement->GetCharacterOwner()->GetController() : nullptr;
+	AController* OldController = Movement->ManagerTickController.Get();
+	if (Controller == OldController)
+	{
+		return;
+	}
+
+	if (OldController)
+	{
+		TickFunction.RemovePrerequisite(OldController, OldController->PrimaryActorTick);
+	}
+	if (Controller)
+	{
+		TickFunction.AddPrerequisite(Controller, Controller->PrimaryActorTick);
+	}
+	Movement->ManagerTickController = Controller;
+}
+
+void UTutMovementManagerSubsystem::TickManaged(float DeltaTime, ELevelTick TickType)
+{
+	if (Components.Num() == 0)
+	{
+		return;
+	}
+
+	{
+		TUT_MOVEMENT_SCOPE(ManagerGates);
+
+		//Anyone who was destroyed, or has been possessed by a player since registering, goes back to ticking on their own.
+		for (int32 Index = Components.Num() - 1; Index >= 0; --Index)
+		{
+			UTutCharacterMovementComponent* Movement = Components[Index];
+			if (!Movement)
+			{
+				Components.RemoveAtSwap(Index);
+			}
+			else if (!IsValid(Movement) || !Movement->CanUseMovementManager())
+			{
+				Unregister(Movement);
+			}
+		}
+
+		Batch.SetNum(Components.Num());
+		for (int32 Index = 0; Index < Components.Num(); ++Index)
+		{
+			Batch.Gather(Index, *Components[Index]);
+		}
+		Batch.ComputeGates();
+
+		//Only the probes TryWallRun is certain to issue: falling, past its early outs, and off cooldown.
+		WallProbes.Reset(Batch.Num());
+		if (GTutParallelWallProbes)
+		{
+			for (int32 Index = 0; Index < Batch.Num(); ++Index)
+			{
+				UTutCharacterMovementComponent* Movement = Components[Index];
+				if ((Batch.Gates[Index] & UTutCharacterMovementComponent::BatchedGateWallRun) && Movement->IsWallProbeDue(DeltaTime) && Movement->CanUseBatchedGates()
+					&& Movement->MayProbeForWallRun())
+				{
+					//Where the surface index rules a wall out, TryWallRun only traces the floor, and does so itself.
+					const FTutWallProbeQuery Query = Movement->MakeWallProbeQuery();
+					if (!Movement->IsWallRunRuledOutBySurfaceIndex(Query))
+					{
+						//Fetched here, so a stale cache is rebuilt on the game thread rather than by a worker.
+						const FCollisionQueryParams& Params = Movement->CustomCharacter->GetIgnoreCharacterParams();
+						WallProbes.Add(Index, Query, Params);
+					}
+				}
+			}
+		}
+	}
+
+	if (WallProbes.Num() > 0)
+	{
+		TUT_MOVEMENT_SCOPE(ManagerWallProbes);
+		WallProbes.Run(GetWorld());
+	}
+
+	//Dispatch. Components[Index] is still Batch slot Index. Characters spawned from here on are added after the batch, and start next frame.
+	bDispatching = true;
+	for (int32 Index = 0; Index < Batch.Num(); ++Index)
+	{
+		UTutCharacterMovementComponent* Movement = Components[Index];
+		if (!Movement || !Movement->IsActive())
+		{
+			continue;
+		}
+
+		//An earlier character may have pushed this one since we gathered, or is about to. Either way it works out its own gates.
+		if (Movement->CanUseBatchedGates() && Batch.IsStillCurrent(Index, *Movement))
+		{
+			Movement->SetBatchedGates(Batch.Gates[Index]);
+
+			const int32 Probe = WallProbes.ProbeForSlot[Index];
+			if (Probe != INDEX_NONE && !WallProbes.PawnNearby[Probe])
+			{
+				Movement->SetPrecomputedWallProbe(WallProbes.Queries[Probe], WallProbes.Results[Probe]);
+			}
+		}
+		Movement->TickComponent(DeltaTime, TickType, &Movement->PrimaryComponentTick);
+	}
+	bDispatching = false;
+}
+
+#pragma endregion
@@ -0,0 +1,166 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "TutWallProbe.h"
+#include "TutMovementManagerSubsystem.generated.h"
+
+class UTutCharacterMovementComponent;
+class UTutMovementManagerSubsystem;
+
+//Ticks the manager once per frame, in the same tick group character movement normally uses.
+USTRUCT()
+struct FTutMovementManagerTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UTutMovementManagerSubsystem* Manager = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FTutMovementManagerTickFunction> : public TStructOpsTypeTraitsBase2<FTutMovementManagerTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/*
+* The state the cheap movement gates need, one array per value (structure of arrays) so a single pass over them stays in cache and can be vectorized.
+* Index i in every array belongs to the same character.
+*/
+struct FTutMovementGateBatch
+{
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+	TArray<float> ForwardX;
+	TArray<float> ForwardY;
+	TArray<float> ForwardZ;
+	TArray<float> MinWallRunSpeedSquared;
+	TArray<float> MaxVerticalWallRunSpeed;
+	//Only read back by IsStillCurrent, to tell whether the gates still apply by the time the character ticks.
+	TArray<uint8> MovementModes;
+	TArray<uint8> CustomMovementModes;
+	//Bits of the Flag constants below.
+	TArray<uint8> Flags;
+
+	//Output, bits of UTutCharacterMovementComponent::BatchedGateSprint and BatchedGateWallRun.
+	TArray<uint8> Gates;
+
+	static constexpr uint8 FlagMovingOnGround = 1 << 0;
+	static constexpr uint8 FlagWantsToSprint = 1 << 1;
+	static constexpr uint8 FlagFalling = 1 << 2;
+
+	int32 Num() const { return Flags.Num(); }
+
+	//Keeps the allocations, so a steady number of characters never reallocates.
+	void SetNum(int32 NewNum);
+
+	//Copies one component's state into slot Index.
+	void Gather(int32 Index, const UTutCharacterMovementComponent& Movement);
+
+	//False if Movement's velocity or movement mode has changed since Gather, because an earlier character pushed it for example, so slot Index's gates are stale.
+	bool IsStillCurrent(int32 Index, const UTutCharacterMovementComponent& Movement) const;
+
+	/*
+	* Works out CanSprint and the early outs of TryWallRun for every slot, without branches or UObject access.
+	* Gives the same answers as UTutCharacterMovementComponent's own checks for the same state. Components that override those don't use the result,
+	* see UTutCharacterMovementComponent::UsesBaseMovementGates.
+	*/
+	void ComputeGates();
+};
+
+/*
+* Wall probes for the managed characters that are about to look for a wall, run in parallel before any of them move.
+* Queries and collision params are gathered on the game thread, the traces only read the scene, and each result is written to its own slot.
+* Probes hit other characters, and those move during the serial pass after the batch ran. So a probe with any pawn near it is skipped,
+* and TryWallRun probes for itself once everyone before it has moved.
+*/
+struct FTutWallProbeBatch
+{
+	//The FTutMovementGateBatch slot each probe belongs to.
+	TArray<int32> Slots;
+	TArray<FTutWallProbeQuery> Queries;
+	TArray<const FCollisionQueryParams*> Params;
+	TArray<FTutWallProbeResult> Results;
+	//A pawn was within reach (plus tut.Movement.ParallelWallProbesPawnMargin) when the batch ran, so Results holds nothing for this probe.
+	TArray<bool> PawnNearby;
+
+	//Per gate batch slot, the probe's index or INDEX_NONE.
+	TArray<int32> ProbeForSlot;
+
+	int32 Num() const { return Queries.Num(); }
+
+	void Reset(int32 NumSlots);
+	void Add(int32 Slot, const FTutWallProbeQuery& Query, const FCollisionQueryParams& InParams);
+
+	//Runs every probe, spread over worker threads when there are enough of them.
+	void Run(const UWorld* World);
+};
+
+/*
+* Opt-in batched movement update for characters the server moves itself (AI, bots).
+*
+* Every component ticking on its own means the cheap checks at the start of every move (CanSprint's forward dot product, TryWallRun's speed checks)
+* are done one character at a time, in between touching each character's UObjects, transforms and physics.
+* Components with bUseMovementManager hand their tick to this subsystem instead. Each frame it:
+* 1. gathers velocity, facing and mode flags from every registered component into FTutMovementGateBatch,
+* 2. runs all the gates in one pass over those arrays,
+* 3. ticks each component as usual, with its gate results handed over so UpdateCharacterStateBeforeMovement doesn't redo them.
+*
+* The physics itself (walking, falling, wall running, sweeps) still runs per character exactly as before, this only batches the work in front of it.
+*
+* With tut.Movement.ParallelWallProbes=1, the wall probes of every falling character that passed its gates also run before step 3, in parallel on worker threads.
+* Nothing moves while they run, so they are read-only scene queries against the same state. Step 3 is then the serial commit: every character moves,
+* and changes mode, one at a time in registration order, as before. A character that got moved (pushed, launched) after its probe ran traces again itself.
+* Player-controlled characters are never managed: their moves are predicted and replayed, and the gates have to be worked out for each of those moves.
+*
+* Compare with per-component ticking using UTutMovementBenchmarkCommandlet's -Batched switch.
+*/
+UCLASS()
+class TUTORIALRESEARCH_API UTutMovementManagerSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	//Takes over the component's tick. It gets it back when unregistered, or when it stops being eligible (see CanUseMovementManager).
+	void Register(UTutCharacterMovementComponent* Movement);
+	void Unregister(UTutCharacterMovementComponent* Movement);
+
+	//Makes our tick wait for the managed character's current controller, instead of the one it had before. See UTutCharacterMovementComponent::OnControllerChanged.
+	void UpdateControllerPrerequisite(UTutCharacterMovementComponent* Movement);
+
+	//One batched update of every registered component. Our tick function calls this, as can tools that tick the world by hand.
+	void TickManaged(float DeltaTime, ELevelTick TickType = LEVELTICK_All);
+
+	int32 GetNumManaged() const { return Components.Num(); }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UTutCharacterMovementComponent>> Components;
+
+	FTutMovementGateBatch Batch;
+	FTutWallProbeBatch WallProbes;
+
+	//While true, Unregister clears slots instead of removing them.
+	bool bDispatching = false;
+
+	FTutMovementManagerTickFunction TickFunction;
+};
@@ -0,0 +1,56 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* The functions that make up one movement mode: its physics, its max speed, and its enter and exit events.
+* Any of them can be left null. A null Phys or MaxSpeed means the engine's default, a null Enter or Exit means the mode has no event.
+*/
+template<typename OwnerType>
+struct TTutMovementModeHandlers
+{
+	using FPhysFunction = void (OwnerType::*)(float, int32);
+	using FMaxSpeedFunction = float (OwnerType::*)() const;
+	using FEventFunction = void (OwnerType::*)();
+
+	FPhysFunction Phys = nullptr;
+	FMaxSpeedFunction MaxSpeed = nullptr;
+	FEventFunction Enter = nullptr;
+	FEventFunction Exit = nullptr;
+};
+
+/*
+* A table of movement mode handlers indexed directly by the mode byte, built at compile time.
+* Dispatching a mode is one array lookup and one call, instead of a switch per function, and adding a mode is one Register call.
+*
+* Bytes outside the table (custom modes only Blueprint knows about, for example) get empty handlers, so they fall back to the defaults.
+*/
+template<typename OwnerType, int32 NumModes>
+class TTutMovementModeRegistry
+{
+public:
+
+	using FHandlers = TTutMovementModeHandlers<OwnerType>;
+
+	constexpr TTutMovementModeRegistry() = default;
+
+	constexpr TTutMovementModeRegistry& Register(uint8 Mode, const FHandlers& InHandlers)
+	{
+		Handlers[Mode] = InHandlers;
+		return *this;
+	}
+
+	const FHandlers& Find(uint8 Mode) const
+	{
+		return Mode < NumModes ? Handlers[Mode] : Empty;
+	}
+
+	static constexpr int32 Num() { return NumModes; }
+
+private:
+
+	FHandlers Handlers[NumModes] = {};
+	static constexpr FHandlers Empty = {};
+};
@@ -0,0 +1,217 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutMovementRecording.h"
+#include "TutCharacterMovementComponent.h"
+#include "MyCustomCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+static AMyCustomCharacter* GetLocalCustomCharacter(UWorld* World)
+{
+	APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	return PlayerController ? Cast<AMyCustomCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTutMovementRecord(
+	TEXT("tut.Movement.Record"),
+	TEXT("Starts recording the local player's movement input. Optional argument: name of the recording. Save it with tut.Movement.StopRecording."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AMyCustomCharacter* Character = GetLocalCustomCharacter(World);
+		if (!Character)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("tut.Movement.Record: there is no local AMyCustomCharacter to record."));
+			return;
+		}
+		Character->GetCustomCharacterMovement()->StartInputRecording(Args.Num() > 0 ? Args[0] : FString());
+	}));
+
+static FAutoConsoleCommandWithWorld CmdTutMovementStopRecording(
+	TEXT("tut.Movement.StopRecording"),
+	TEXT("Stops recording the local player's movement input and saves it to Saved/Profiling/TutRecordings."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (AMyCustomCharacter* Character = GetLocalCustomCharacter(World))
+		{
+			Character->GetCustomCharacterMovement()->StopInputRecording();
+		}
+	}));
+
+FTutRecordedMovementState FTutRecordedMovementState::Capture(const UTutCharacterMovementComponent& Movement)
+{
+	FTutRecordedMovementState State;
+	State.Location = Movement.UpdatedComponent->GetComponentLocation();
+	State.Rotation = Movement.UpdatedComponent->GetComponentRotation();
+	State.Velocity = Movement.Velocity;
+	State.MovementMode = Movement.MovementMode;
+	State.CustomMovementMode = Movement.CustomMovementMode;
+	State.bWallRunIsRight = Movement.bWallRunIsRight;
+	return State;
+}
+
+void FTutRecordedMovementState::Apply(UTutCharacterMovementComponent& Movement) const
+{
+	Movement.UpdatedComponent->SetWorldLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	Movement.SetMovementMode((EMovementMode)MovementMode, CustomMovementMode);
+	//After the mode change, as entering some modes changes the velocity.
+	Movement.Velocity = Velocity;
+	Movement.bWallRunIsRight = bWallRunIsRight;
+}
+
+FArchive& operator<<(FArchive& Ar, FTutRecordedMovementState& State)
+{
+	Ar << State.Location << State.Rotation << State.Velocity << State.MovementMode << State.CustomMovementMode << State.bWallRunIsRight;
+	return Ar;
+}
+
+namespace TutMovementRecording
+{
+	//What follows each frame's bit byte.
+	enum EFrameBits : uint8
+	{
+		Frame_WantsToSprint = 1 << 0,
+		Frame_PressedJump = 1 << 1,
+		Frame_DeltaChanged = 1 << 2,
+		Frame_InputChanged = 1 << 3,
+		Frame_FlagsChanged = 1 << 4,
+		Frame_Launch = 1 << 5,
+	};
+}
+
+void FTutMovementRecording::Serialize(FArchive& Ar)
+{
+	using namespace TutMovementRecording;
+
+	uint32 Magic = FileMagic;
+	uint16 Version = FileVersion;
+	Ar << Magic << Version;
+	if (Ar.IsLoading() && (Magic != FileMagic || Version != FileVersion))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << MapName << CharacterClassPath << StartState << EndState;
+
+	int32 NumFrames = Frames.Num();
+	Ar << NumFrames;
+	if (Ar.IsLoading())
+	{
+		if (NumFrames < 0 || NumFrames > Ar.TotalSize())
+		{
+			Ar.SetError();
+			return;
+		}
+		Frames.SetNum(NumFrames);
+	}
+
+	/*
+	* Frames are written relative to the one before. The first frame always writes everything.
+	* Values are written at full precision, so replays feed the exact same numbers the live session did.
+	*/
+	FTutRecordedMoveInput Previous;
+	Previous.DeltaSeconds = -1.f;
+	bool bFirstFrame = true;
+
+	for (FTutRecordedMoveInput& Frame : Frames)
+	{
+		uint8 Bits = 0;
+		if (Ar.IsSaving())
+		{
+			Bits |= Frame.bWantsToSprint ? Frame_WantsToSprint : 0;
+			Bits |= Frame.bPressedJump ? Frame_PressedJump : 0;
+			Bits |= Frame.DeltaSeconds != Previous.DeltaSeconds ? Frame_DeltaChanged : 0;
+			Bits |= bFirstFrame || Frame.InputVector != Previous.InputVector ? Frame_InputChanged : 0;
+			Bits |= bFirstFrame || Frame.MovementFlagCustom != Previous.MovementFlagCustom ? Frame_FlagsChanged : 0;
+			Bits |= !Frame.LaunchVelocity.IsZero() ? Frame_Launch : 0;
+		}
+		Ar << Bits;
+
+		Frame.bWantsToSprint = (Bits & Frame_WantsToSprint) != 0;
+		Frame.bPressedJump = (Bits & Frame_PressedJump) != 0;
+
+		if (Bits & Frame_DeltaChanged)
+		{
+			Ar << Frame.DeltaSeconds;
+		}
+		else
+		{
+			Frame.DeltaSeconds = Previous.DeltaSeconds;
+		}
+
+		if (Bits & Frame_InputChanged)
+		{
+			Ar << Frame.InputVector;
+		}
+		else
+		{
+			Frame.InputVector = Previous.InputVector;
+		}
+
+		if (Bits & Frame_FlagsChanged)
+		{
+			Ar << Frame.MovementFlagCustom;
+		}
+		else
+		{
+			Frame.MovementFlagCustom = Previous.MovementFlagCustom;
+		}
+
+		if (Bits & Frame_Launch)
+		{
+			Ar << Frame.LaunchVelocity;
+		}
+		else
+		{
+			Frame.LaunchVelocity = FVector::ZeroVector;
+		}
+
+		if (Ar.IsError())
+		{
+			return;
+		}
+
+		Previous = Frame;
+		bFirstFrame = false;
+	}
+}
+
+bool FTutMovementRecording::SaveToFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Serialize(Writer);
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FTutMovementRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Serialize(Reader);
+	return !Reader.IsError();
+}
+
+FString FTutMovementRecording::ResolveFilename(const FString& NameOrPath)
+{
+	if (NameOrPath.IsEmpty())
+	{
+		return FPaths::ProfilingDir() / TEXT("TutRecordings") / FString::Printf(TEXT("Recording-%s.tutrec"), *FDateTime::Now().ToString());
+	}
+	if (FPaths::GetExtension(NameOrPath).IsEmpty() && FPaths::GetPath(NameOrPath).IsEmpty())
+	{
+		return FPaths::ProfilingDir() / TEXT("TutRecordings") / NameOrPath + TEXT(".tutrec");
+	}
+	return NameOrPath;
+}
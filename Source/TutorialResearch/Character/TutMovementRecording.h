@@ -0,0 +1,83 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UTutCharacterMovementComponent;
+
+/*
+* Everything that feeds one ControlledCharacterMove of UTutCharacterMovementComponent.
+* It is the same input a saved move carries (acceleration, bWantsToSprint, MovementFlagCustom, jump, launch), captured before the move runs.
+*/
+struct FTutRecordedMoveInput
+{
+	float DeltaSeconds = 0.f;
+
+	//Pending movement input in world space, before it is turned into acceleration. Feeding this back gives the same acceleration.
+	FVector InputVector = FVector::ZeroVector;
+
+	bool bWantsToSprint = false;
+	bool bPressedJump = false;
+
+	//Includes the speed tier and the fly flag.
+	uint8 MovementFlagCustom = 0;
+
+	//The final launch velocity from LaunchCharacterReplicated, zero if there was no launch this frame.
+	FVector LaunchVelocity = FVector::ZeroVector;
+};
+
+//Where the character was and what it was doing, at the start and at the end of a recording.
+struct FTutRecordedMovementState
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FVector Velocity = FVector::ZeroVector;
+	uint8 MovementMode = 0;
+	uint8 CustomMovementMode = 0;
+	bool bWallRunIsRight = false;
+
+	static FTutRecordedMovementState Capture(const UTutCharacterMovementComponent& Movement);
+	void Apply(UTutCharacterMovementComponent& Movement) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FTutRecordedMovementState& State);
+};
+
+/*
+* A recorded session of one character's movement input, for replaying offline. See UTutMovementReplayCommandlet.
+*
+* The file is compact: each frame is one byte of bits, followed by only the values that changed since the previous frame.
+* Held input costs a byte per frame, analog input about 25.
+*
+* Recording, on the owning client or a listen server host:
+* "tut.Movement.Record [Name]" starts recording the local player's character, "tut.Movement.StopRecording" saves it.
+* Starting the game with -TutRecordInput records the local player's character from its first move until it ends play.
+* Files are saved to Saved/Profiling/TutRecordings/<Name>.tutrec.
+*/
+class TUTORIALRESEARCH_API FTutMovementRecording
+{
+public:
+
+	//Package name of the map it was recorded on, and the character class, so the replay can set up the same thing.
+	FString MapName;
+	FString CharacterClassPath;
+
+	FTutRecordedMovementState StartState;
+	FTutRecordedMovementState EndState;
+
+	TArray<FTutRecordedMoveInput> Frames;
+
+	//Saving and loading share Serialize, which is why saving isn't const.
+	bool SaveToFile(const FString& Filename);
+	bool LoadFromFile(const FString& Filename);
+
+	//A bare name is looked up in the recordings folder. Paths and names with an extension are used as they are.
+	static FString ResolveFilename(const FString& NameOrPath);
+
+private:
+
+	void Serialize(FArchive& Ar);
+
+	static constexpr uint32 FileMagic = 0x52545554; //"TUTR"
+	static constexpr uint16 FileVersion = 1;
+};
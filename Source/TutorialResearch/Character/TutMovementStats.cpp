@@ -0,0 +1,64 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutMovementStats.h"
+
+DEFINE_STAT(STAT_TutIgnoreParamsRebuilds);
+DEFINE_STAT(STAT_TutIgnoreParamsCacheHits);
+DEFINE_STAT(STAT_TutWallContactTraces);
+DEFINE_STAT(STAT_TutWallTracesSaved);
+DEFINE_STAT(STAT_TutWallProbeTraces);
+DEFINE_STAT(STAT_TutAsyncWallProbeRequests);
+DEFINE_STAT(STAT_TutWallProbesSkippedBySurfaceIndex);
+
+DEFINE_STAT(STAT_TutSavedMoveRequests);
+DEFINE_STAT(STAT_TutSavedMoveAllocations);
+DEFINE_STAT(STAT_TutSavedMovesPooled);
+DEFINE_STAT(STAT_TutSavedMoveHeapFallbacks);
+
+DEFINE_STAT(STAT_TutCombineAttemptsWalking);
+DEFINE_STAT(STAT_TutCombineHitsWalking);
+DEFINE_STAT(STAT_TutCombineAttemptsFalling);
+DEFINE_STAT(STAT_TutCombineHitsFalling);
+DEFINE_STAT(STAT_TutCombineAttemptsFlying);
+DEFINE_STAT(STAT_TutCombineHitsFlying);
+DEFINE_STAT(STAT_TutCombineAttemptsWallRunning);
+DEFINE_STAT(STAT_TutCombineHitsWallRunning);
+DEFINE_STAT(STAT_TutCombineAttemptsOther);
+DEFINE_STAT(STAT_TutCombineHitsOther);
+DEFINE_STAT(STAT_TutProxyLODFull);
+DEFINE_STAT(STAT_TutProxyLODReduced);
+DEFINE_STAT(STAT_TutProxyLODFrozen);
+DEFINE_STAT(STAT_TutManagedCharacters);
+
+DEFINE_STAT(STAT_TutPhysCustom);
+DEFINE_STAT(STAT_TutPhysWallRun);
+DEFINE_STAT(STAT_TutTryWallRun);
+DEFINE_STAT(STAT_TutCanSprint);
+DEFINE_STAT(STAT_TutMoveAutonomous);
+DEFINE_STAT(STAT_TutCanCombineWith);
+DEFINE_STAT(STAT_TutSerializeMoveData);
+DEFINE_STAT(STAT_TutSerializeMoveContainer);
+DEFINE_STAT(STAT_TutManagerGates);
+DEFINE_STAT(STAT_TutManagerWallProbes);
+DEFINE_STAT(STAT_TutSurfaceIndexQuery);
+
+DEFINE_STAT(STAT_TutPhysCustomCalls);
+DEFINE_STAT(STAT_TutPhysWallRunCalls);
+DEFINE_STAT(STAT_TutTryWallRunCalls);
+DEFINE_STAT(STAT_TutCanSprintCalls);
+DEFINE_STAT(STAT_TutMoveAutonomousCalls);
+DEFINE_STAT(STAT_TutCanCombineWithCalls);
+DEFINE_STAT(STAT_TutSerializeMoveDataCalls);
+DEFINE_STAT(STAT_TutSerializeMoveContainerCalls);
+DEFINE_STAT(STAT_TutManagerGatesCalls);
+DEFINE_STAT(STAT_TutManagerWallProbesCalls);
+DEFINE_STAT(STAT_TutSurfaceIndexQueryCalls);
+
+DEFINE_STAT(STAT_TutModeWalking);
+DEFINE_STAT(STAT_TutModeFalling);
+DEFINE_STAT(STAT_TutModeFlying);
+DEFINE_STAT(STAT_TutModeSwimming);
+DEFINE_STAT(STAT_TutModeWallRunning);
+DEFINE_STAT(STAT_TutModeOther);
+
+UE_TRACE_CHANNEL_DEFINE(TutMovementChannel);
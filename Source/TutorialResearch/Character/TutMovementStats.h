@@ -0,0 +1,113 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/*
+* Stats for our custom movement. Type "stat TutMovement" in the console to view them.
+* Counter stats are reset every frame, so the values you see are per frame across every character in the world.
+*/
+DECLARE_STATS_GROUP(TEXT("TutMovement"), STATGROUP_TutMovement, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ignore Params Rebuilds"), STAT_TutIgnoreParamsRebuilds, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ignore Params Cache Hits"), STAT_TutIgnoreParamsCacheHits, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+//Every line trace that goes through FTutWallProbe, and every async overlap we queue.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wall Probe Traces"), STAT_TutWallProbeTraces, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async Wall Probe Requests"), STAT_TutAsyncWallProbeRequests, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+//Wall probes cut down to the floor trace, because neither the level's wall run surface index nor any unbaked collision had anything within reach.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wall Probes Skipped By Surface Index"), STAT_TutWallProbesSkippedBySurfaceIndex, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+/*
+* Saved move pool. These accumulate instead of resetting every frame.
+* Requests is every AllocateNewMove call, Allocations is how many of those actually had to create a move.
+* Pooled is how many moves the pools of every character hold right now. Each pool's own high-water mark is in the net soak report.
+*/
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Saved Move Requests"), STAT_TutSavedMoveRequests, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Saved Move Allocations"), STAT_TutSavedMoveAllocations, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Saved Moves Pooled"), STAT_TutSavedMovesPooled, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Saved Move Heap Fallbacks"), STAT_TutSavedMoveHeapFallbacks, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+/*
+* Wall contact cache (FTutWallContactCache). Traces is every wall trace it had to do, Saved is every one it answered from the cached hit.
+* Saved / (Traces + Saved) is the hit rate. These accumulate, since a wall run only lasts a handful of frames and a per-frame count says little.
+*/
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Wall Contact Traces"), STAT_TutWallContactTraces, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Wall Contact Traces Saved"), STAT_TutWallTracesSaved, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+/*
+* Move combining, per movement mode. Hits / attempts is the combine ratio. Every hit is one less move the client has to send.
+* These accumulate, so the ratio covers the whole session rather than a single frame.
+*/
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Attempts: Walking"), STAT_TutCombineAttemptsWalking, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Hits: Walking"), STAT_TutCombineHitsWalking, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Attempts: Falling"), STAT_TutCombineAttemptsFalling, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Hits: Falling"), STAT_TutCombineHitsFalling, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Attempts: Flying"), STAT_TutCombineAttemptsFlying, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Hits: Flying"), STAT_TutCombineHitsFlying, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Attempts: Wall Running"), STAT_TutCombineAttemptsWallRunning, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Hits: Wall Running"), STAT_TutCombineHitsWallRunning, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Attempts: Other"), STAT_TutCombineAttemptsOther, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Combine Hits: Other"), STAT_TutCombineHitsOther, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+//Simulated proxies in each ETutProxyLOD tier on this client, right now.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Sim Proxies: Full"), STAT_TutProxyLODFull, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Sim Proxies: Reduced"), STAT_TutProxyLODReduced, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Sim Proxies: Frozen"), STAT_TutProxyLODFrozen, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+//Characters ticked by UTutMovementManagerSubsystem, right now.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Managed Characters"), STAT_TutManagedCharacters, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+/*
+* Hot path timings. Each one has a cycle stat and a matching call counter, see TUT_MOVEMENT_SCOPE below.
+*/
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysCustom"), STAT_TutPhysCustom, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysWallRun"), STAT_TutPhysWallRun, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("TryWallRun"), STAT_TutTryWallRun, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CanSprint"), STAT_TutCanSprint, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MoveAutonomous"), STAT_TutMoveAutonomous, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CanCombineWith"), STAT_TutCanCombineWith, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Serialize Move Data"), STAT_TutSerializeMoveData, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Serialize Move Container"), STAT_TutSerializeMoveContainer, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager Gates"), STAT_TutManagerGates, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager Wall Probes"), STAT_TutManagerWallProbes, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Surface Index Query"), STAT_TutSurfaceIndexQuery, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("PhysCustom Calls"), STAT_TutPhysCustomCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("PhysWallRun Calls"), STAT_TutPhysWallRunCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("TryWallRun Calls"), STAT_TutTryWallRunCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CanSprint Calls"), STAT_TutCanSprintCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("MoveAutonomous Calls"), STAT_TutMoveAutonomousCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CanCombineWith Calls"), STAT_TutCanCombineWithCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Serialize Move Data Calls"), STAT_TutSerializeMoveDataCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Serialize Move Container Calls"), STAT_TutSerializeMoveContainerCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Manager Gates Calls"), STAT_TutManagerGatesCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Manager Wall Probes Calls"), STAT_TutManagerWallProbesCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Surface Index Query Calls"), STAT_TutSurfaceIndexQueryCalls, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+/*
+* Time spent in each movement mode, measured around StartNewPhysics. This splits the engine's single "CharacterMovement" block up by mode.
+* Modes can change mid-tick, so a mode's scope can be nested inside the previous one.
+*/
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mode: Walking"), STAT_TutModeWalking, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mode: Falling"), STAT_TutModeFalling, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mode: Flying"), STAT_TutModeFlying, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mode: Swimming"), STAT_TutModeSwimming, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mode: Wall Running"), STAT_TutModeWallRunning, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mode: Other"), STAT_TutModeOther, STATGROUP_TutMovement, TUTORIALRESEARCH_API);
+
+/*
+* Unreal Insights channel for the same scopes. Stats aren't available on every build, but trace events are, so this is what to use on a headless server.
+* Example: MyServer -nullrhi -trace=cpu,TutMovement -tracehost=127.0.0.1 (or -tracefile to write a .utrace to Saved/Profiling)
+*/
+UE_TRACE_CHANNEL_EXTERN(TutMovementChannel, TUTORIALRESEARCH_API);
+
+//Times the enclosing scope as a cycle stat and an Insights event, and counts the call.
+#define TUT_MOVEMENT_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Tut##Name); \
+	INC_DWORD_STAT(STAT_Tut##Name##Calls); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Tut##Name, TutMovementChannel)
@@ -0,0 +1,8 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutNavArea_WallRun.h"
+
+UTutNavArea_WallRun::UTutNavArea_WallRun(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	DrawColor = FColor(255, 128, 0);
+}
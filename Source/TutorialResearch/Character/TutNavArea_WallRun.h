@@ -0,0 +1,21 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NavAreas/NavArea.h"
+#include "TutNavArea_WallRun.generated.h"
+
+/*
+* Marks navmesh where AI characters may wall run, usually with a Nav Modifier Volume along a runnable wall.
+* UTutAIMovementComponent only looks for walls while its path goes through this area, instead of probing on every falling tick.
+*/
+UCLASS(Config = Engine)
+class TUTORIALRESEARCH_API UTutNavArea_WallRun : public UNavArea
+{
+	GENERATED_BODY()
+
+public:
+
+	UTutNavArea_WallRun(const FObjectInitializer& ObjectInitializer);
+};
@@ -0,0 +1,181 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+// Wall running example adapted from Zippy - Copyright (c) 2022 William (https://github.com/delgoodie/Zippy)
+
+#include "TutWallProbe.h"
+#include "Engine/World.h"
+#include "Engine/CollisionProfile.h"
+#include "Components/PrimitiveComponent.h"
+#include "TutMovementStats.h"
+#include <atomic>
+
+const FName FTutWallProbe::ProfileName(TEXT("BlockAll"));
+
+//Movement can tick on more than one thread, so this is atomic. Relaxed ordering is plenty for a counter.
+static std::atomic<uint64> GTutWallProbeTraceCount(0);
+
+const FTutWallProbe::FResolvedProfile& FTutWallProbe::GetResolvedProfile()
+{
+	//Collision profiles are loaded from config before any world exists, so resolving on first use is safe.
+	static const FResolvedProfile Resolved = []()
+	{
+		FResolvedProfile Profile;
+		UCollisionProfile::GetChannelAndResponseParams(ProfileName, Profile.Channel, Profile.ResponseParams);
+		return Profile;
+	}();
+
+	return Resolved;
+}
+
+bool FTutWallProbe::Trace(const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params)
+{
+	INC_DWORD_STAT(STAT_TutWallProbeTraces);
+	GTutWallProbeTraceCount.fetch_add(1, std::memory_order_relaxed);
+
+	const FResolvedProfile& Profile = GetResolvedProfile();
+	return World->LineTraceSingleByChannel(OutHit, Start, End, Profile.Channel, Params, Profile.ResponseParams);
+}
+
+uint64 FTutWallProbe::GetTraceCount()
+{
+	return GTutWallProbeTraceCount.load(std::memory_order_relaxed);
+}
+
+void FTutWallProbe::ProbeForWallRun(const UWorld* World, const FTutWallProbeQuery& Query, const FCollisionQueryParams& Params, FTutWallProbeResult& OutResult)
+{
+	OutResult = FTutWallProbeResult();
+
+	// Check Player Height
+	FHitResult FloorHit;
+	if (Trace(World, FloorHit, Query.Start, Query.Start + FVector::DownVector * Query.FloorDistance, Params))
+	{
+		OutResult.bFloorTooClose = true;
+		return;
+	}
+
+	const FVector CastDelta = Query.RightVector * Query.SideDistance;
+
+	// Left Cast
+	Trace(World, OutResult.WallHit, Query.Start, Query.Start - CastDelta, Params);
+	if (OutResult.WallHit.IsValidBlockingHit() && (Query.Velocity | OutResult.WallHit.Normal) < 0)
+	{
+		OutResult.bWallIsRight = false;
+		return;
+	}
+
+	// Right Cast
+	Trace(World, OutResult.WallHit, Query.Start, Query.Start + CastDelta, Params);
+	if (OutResult.WallHit.IsValidBlockingHit() && (Query.Velocity | OutResult.WallHit.Normal) < 0)
+	{
+		OutResult.bWallIsRight = true;
+		return;
+	}
+
+	//Neither side is runnable.
+	OutResult.WallHit = FHitResult();
+}
+
+bool FTutAsyncWallProbe::RulesOutWallRun(UWorld* World, const FTutWallProbeQuery& Query) const
+{
+	if (!Handle.IsValid())
+	{
+		return false;
+	}
+
+	FOverlapDatum OverlapData;
+	if (!World->QueryOverlapData(Handle, OverlapData))
+	{
+		return false;
+	}
+
+	//The synchronous probes reach this far from Query.Start, so all of it has to be inside the sphere we checked.
+	const float Reach = FMath::Max(Query.SideDistance, Query.FloorDistance);
+	if (FVector::Dist(Query.Start, Center) + Reach > Radius)
+	{
+		return false;
+	}
+
+	for (const FOverlapResult& Overlap : OverlapData.OutOverlaps)
+	{
+		if (Overlap.bBlockingHit)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FTutAsyncWallProbe::Request(UWorld* World, const FTutWallProbeQuery& Query, float DeltaSeconds, float Margin, const FCollisionQueryParams& Params)
+{
+	if (RequestFrame == GFrameCounter)
+	{
+		return;
+	}
+	RequestFrame = GFrameCounter;
+	INC_DWORD_STAT(STAT_TutAsyncWallProbeRequests);
+
+	Center = Query.Start + Query.Velocity * DeltaSeconds;
+	Radius = FMath::Max(Query.SideDistance, Query.FloorDistance) + Margin;
+
+	const FTutWallProbe::FResolvedProfile& Profile = FTutWallProbe::GetResolvedProfile();
+	Handle = World->AsyncOverlapByChannel(Center, FQuat::Identity, Profile.Channel, FCollisionShape::MakeSphere(Radius), Params, Profile.ResponseParams);
+}
+
+bool FTutWallContactCache::TraceWall(const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params, float Threshold)
+{
+	if (CanReuse(Start, End, Threshold))
+	{
+		INC_DWORD_STAT(STAT_TutWallTracesSaved);
+
+		//Slide the cached hit along the wall so it lines up with where we are now.
+		const FVector Offset = FVector::VectorPlaneProject(Start - CachedStart, CachedHit.Normal);
+		OutHit = CachedHit;
+		OutHit.TraceStart = Start;
+		OutHit.TraceEnd = End;
+		OutHit.Location += Offset;
+		OutHit.ImpactPoint += Offset;
+		return true;
+	}
+
+	INC_DWORD_STAT(STAT_TutWallContactTraces);
+	const bool bHit = FTutWallProbe::Trace(World, OutHit, Start, End, Params);
+
+	bValid = bHit && OutHit.IsValidBlockingHit() && OutHit.GetComponent() != nullptr;
+	if (bValid)
+	{
+		CachedHit = OutHit;
+		CachedStart = Start;
+		CachedDirection = (End - Start).GetSafeNormal();
+		CachedComponent = OutHit.GetComponent();
+		CachedComponentTransform = CachedComponent->GetComponentTransform();
+	}
+
+	return bHit;
+}
+
+bool FTutWallContactCache::CanReuse(const FVector& Start, const FVector& End, float Threshold) const
+{
+	if (!bValid || Threshold <= 0.f)
+	{
+		return false;
+	}
+
+	//Different wall component, or the wall moved under us.
+	const UPrimitiveComponent* Component = CachedComponent.Get();
+	if (!Component || !Component->GetComponentTransform().Equals(CachedComponentTransform))
+	{
+		return false;
+	}
+
+	//Switched sides or turned.
+	if ((CachedDirection | (End - Start).GetSafeNormal()) < 0.999f)
+	{
+		return false;
+	}
+
+	//Both the distance travelled along the wall and the distance to or from the wall must stay under the threshold.
+	const FVector Delta = Start - CachedStart;
+	const float DistanceFromPlane = FMath::Abs(Delta | CachedHit.Normal);
+	const float DistanceAlongPlane = FVector::VectorPlaneProject(Delta, CachedHit.Normal).Size();
+	return DistanceFromPlane < Threshold && DistanceAlongPlane < Threshold;
+}
@@ -0,0 +1,141 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+// Wall running example adapted from Zippy - Copyright (c) 2022 William (https://github.com/delgoodie/Zippy)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "CollisionQueryParams.h"
+#include "WorldCollision.h"
+
+/*
+* Everything needed to probe for a runnable wall from a single position.
+*/
+struct FTutWallProbeQuery
+{
+	//Usually the capsule centre.
+	FVector Start = FVector::ZeroVector;
+
+	//The capsule's right vector. The left probe simply goes the opposite way.
+	FVector RightVector = FVector::RightVector;
+
+	//How far to the side we look for a wall.
+	float SideDistance = 0.f;
+
+	//How far below Start the floor must be for us to be allowed to wall run.
+	float FloorDistance = 0.f;
+
+	//Walls we are moving away from are ignored.
+	FVector Velocity = FVector::ZeroVector;
+
+	bool operator==(const FTutWallProbeQuery& Other) const
+	{
+		return Start == Other.Start && RightVector == Other.RightVector && SideDistance == Other.SideDistance
+			&& FloorDistance == Other.FloorDistance && Velocity == Other.Velocity;
+	}
+};
+
+struct FTutWallProbeResult
+{
+	//There is floor within FloorDistance, so the side probes were skipped.
+	bool bFloorTooClose = false;
+
+	bool bWallIsRight = false;
+
+	FHitResult WallHit;
+
+	bool HasWall() const { return !bFloorTooClose && WallHit.IsValidBlockingHit(); }
+};
+
+/*
+* All of our wall running traces go through here.
+* The movement code used to call LineTraceSingleByProfile with "BlockAll", which looks the profile up by name on every single trace.
+* We resolve the profile into a channel and response params once and trace by channel from then on.
+* ProbeForWallRun also bundles the floor + left + right probes used to start a wall run, bailing out as soon as the result is known.
+*/
+class TUTORIALRESEARCH_API FTutWallProbe
+{
+public:
+
+	//The collision profile all wall running traces use.
+	static const FName ProfileName;
+
+	//A single line trace against the wall running profile. Returns true on a blocking hit.
+	static bool Trace(const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params);
+
+	//Floor first (cheapest way to rule a wall run out), then left, then right. Same rules as the original TryWallRun.
+	//Only reads the scene, so it is safe to call from worker threads while nothing is moving (see UTutMovementManagerSubsystem).
+	static void ProbeForWallRun(const UWorld* World, const FTutWallProbeQuery& Query, const FCollisionQueryParams& Params, FTutWallProbeResult& OutResult);
+
+	//The channel every wall probe traces on, resolved from ProfileName.
+	static ECollisionChannel GetTraceChannel() { return GetResolvedProfile().Channel; }
+
+	//Every trace issued through Trace since startup. Unlike the stats this is counted in every build configuration, so tools like the movement benchmark can rely on it.
+	static uint64 GetTraceCount();
+
+private:
+
+	friend class FTutAsyncWallProbe;
+
+	struct FResolvedProfile
+	{
+		ECollisionChannel Channel = ECC_WorldStatic;
+		FCollisionResponseParams ResponseParams;
+	};
+
+	static const FResolvedProfile& GetResolvedProfile();
+};
+
+/*
+* Server-side wall candidacy, probed with an async overlap one frame ahead.
+* Every frame we request an overlap around where we expect the capsule to be next frame. The result arrives the following frame.
+* If that overlap found no blocking geometry at all, and it fully covers everything the synchronous probes would have traced, the probes can't find a wall either, so we skip them.
+* In every other case (no result yet, we ended up somewhere else, something is nearby) the caller falls back to the synchronous probes.
+* Because we only ever skip traces that were guaranteed to fail, the server reaches the same decision as a client using the synchronous path.
+*/
+class TUTORIALRESEARCH_API FTutAsyncWallProbe
+{
+public:
+
+	//True if last frame's overlap is ready and proves there is nothing to wall run on (or stand on) around Query.Start.
+	bool RulesOutWallRun(UWorld* World, const FTutWallProbeQuery& Query) const;
+
+	//Requests next frame's overlap at our predicted location. Only the first request each frame is issued.
+	void Request(UWorld* World, const FTutWallProbeQuery& Query, float DeltaSeconds, float Margin, const FCollisionQueryParams& Params);
+
+	void Reset() { Handle = FTraceHandle(); }
+
+private:
+
+	FTraceHandle Handle;
+	FVector Center = FVector::ZeroVector;
+	float Radius = 0.f;
+	uint64 RequestFrame = 0;
+};
+
+/*
+* Remembers the wall we are running along so PhysWallRun doesn't have to trace for it on every sub-step.
+* A planar wall looks the same from anywhere nearby, so as long as we have only moved a little since the last trace (and the wall itself hasn't moved),
+* the previous hit is reused. We trace again once we move more than the threshold, change side, or the wall's component moves or goes away.
+* Misses are never cached, they end the wall run anyway.
+*/
+class TUTORIALRESEARCH_API FTutWallContactCache
+{
+public:
+
+	//Same contract as FTutWallProbe::Trace. A Threshold of 0 disables the cache.
+	bool TraceWall(const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params, float Threshold);
+
+	void Reset() { bValid = false; }
+
+private:
+
+	bool CanReuse(const FVector& Start, const FVector& End, float Threshold) const;
+
+	FHitResult CachedHit;
+	FVector CachedStart = FVector::ZeroVector;
+	FVector CachedDirection = FVector::ZeroVector;
+	TWeakObjectPtr<UPrimitiveComponent> CachedComponent;
+	FTransform CachedComponentTransform;
+	bool bValid = false;
+};
@@ -0,0 +1,676 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutWallRunSurfaceIndex.h"
+#include "TutWallProbe.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Engine/StaticMesh.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Interface_CollisionDataProvider.h"
+#include "Misc/PackageName.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTutWallRunIndex);
+
+static bool GTutUseWallRunSurfaceIndex = true;
+static FAutoConsoleVariableRef CVarTutUseWallRunSurfaceIndex(
+	TEXT("tut.Movement.WallRunSurfaceIndex"),
+	GTutUseWallRunSurfaceIndex,
+	TEXT("Check the level's baked wall run surface index before tracing for a wall to run on. 0 always traces."));
+
+namespace TutWallRunSurfaceIndex
+{
+	/*
+	* Collects triangles into one list of points per plane, so a wall made of many triangles becomes one surface rather than one per triangle.
+	* Planes are bucketed by rounded normal and distance. A plane that straddles a rounding boundary ends up as two overlapping surfaces, which is harmless.
+	*/
+	struct FPlaneGroups
+	{
+		TMap<TPair<FIntVector, int32>, int32> Lookup;
+		TArray<FVector> Normals;
+		TArray<TArray<FVector>> Points;
+
+		void AddTriangle(const FVector& A, const FVector& B, const FVector& C)
+		{
+			FVector Normal = (B - A) ^ (C - A);
+			if (!Normal.Normalize())
+			{
+				//Degenerate.
+				return;
+			}
+
+			const FIntVector RoundedNormal(FMath::RoundToInt(Normal.X * 100.f), FMath::RoundToInt(Normal.Y * 100.f), FMath::RoundToInt(Normal.Z * 100.f));
+			const int32 RoundedDistance = FMath::RoundToInt((Normal | A) * 0.5f);
+
+			int32& Group = Lookup.FindOrAdd(TPair<FIntVector, int32>(RoundedNormal, RoundedDistance), INDEX_NONE);
+			if (Group == INDEX_NONE)
+			{
+				Group = Normals.Add(Normal);
+				Points.AddDefaulted();
+			}
+			Points[Group].Append({ A, B, C });
+		}
+	};
+}
+
+#pragma region Surface
+
+float FTutWallRunSurface::GetDistanceSquared(const FVector& Location) const
+{
+	const FVector Delta = Location - Center;
+	const FVector Up = GetUpDirection();
+	const float Along = FMath::Clamp(Delta | RunDirection, -HalfExtent.X, HalfExtent.X);
+	const float Vertical = FMath::Clamp(Delta | Up, -HalfExtent.Y, HalfExtent.Y);
+	return FVector::DistSquared(Location, Center + RunDirection * Along + Up * Vertical);
+}
+
+FBox FTutWallRunSurface::GetBounds() const
+{
+	const FVector Along = RunDirection * HalfExtent.X;
+	const FVector Vertical = GetUpDirection() * HalfExtent.Y;
+
+	FBox Bounds(ForceInit);
+	Bounds += Center + Along + Vertical;
+	Bounds += Center + Along - Vertical;
+	Bounds += Center - Along + Vertical;
+	Bounds += Center - Along - Vertical;
+	return Bounds;
+}
+
+#pragma endregion
+
+#pragma region Index
+
+FString UTutWallRunSurfaceIndex::GetPackageNameForMap(const FString& MapPackageName)
+{
+	return MapPackageName + TEXT("_WallRunIndex");
+}
+
+FIntVector UTutWallRunSurfaceIndex::GetCellCoord(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / Settings.CellSize),
+		FMath::FloorToInt(Location.Y / Settings.CellSize),
+		FMath::FloorToInt(Location.Z / Settings.CellSize));
+}
+
+void UTutWallRunSurfaceIndex::Build(const UWorld* World, const FTutWallRunSurfaceBuildSettings& InSettings)
+{
+	Settings = InSettings;
+	Settings.CellSize = FMath::Max(Settings.CellSize, 10.f);
+	MapName = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	Surfaces.Reset();
+	UncoveredBounds.Reset();
+	Cells.Reset();
+	CellSurfaces.Reset();
+	CellBounds.Reset();
+
+	//The same channel the wall probes trace on. Anything that doesn't block it can't be wall run on.
+	const ECollisionChannel Channel = FTutWallProbe::GetTraceChannel();
+
+	for (const ULevel* Level : World->GetLevels())
+	{
+		if (!Level)
+		{
+			continue;
+		}
+
+		for (const AActor* Actor : Level->Actors)
+		{
+			if (!Actor)
+			{
+				continue;
+			}
+
+			Actor->ForEachComponent<UPrimitiveComponent>(false, [this, Channel](UPrimitiveComponent* Component)
+			{
+				if (!Component->IsRegistered() || Component->Mobility == EComponentMobility::Movable
+					|| !Component->IsQueryCollisionEnabled() || Component->GetCollisionResponseToChannel(Channel) != ECR_Block)
+				{
+					return;
+				}
+
+				if (const UInstancedStaticMeshComponent* Instanced = Cast<UInstancedStaticMeshComponent>(Component))
+				{
+					for (int32 Instance = 0; Instance < Instanced->GetInstanceCount(); ++Instance)
+					{
+						FTransform InstanceTransform;
+						Instanced->GetInstanceTransform(Instance, InstanceTransform, true);
+						if (!AddCollision(*Component, InstanceTransform))
+						{
+							const UStaticMesh* Mesh = Instanced->GetStaticMesh();
+							UncoveredBounds.Add(Mesh ? Mesh->GetBounds().GetBox().TransformBy(InstanceTransform) : Component->Bounds.GetBox());
+						}
+					}
+				}
+				else if (!AddCollision(*Component, Component->GetComponentTransform()))
+				{
+					UncoveredBounds.Add(Component->Bounds.GetBox());
+				}
+			});
+		}
+	}
+
+	//Every surface and every uncovered box goes into each cell its bounds touch.
+	struct FBucket
+	{
+		TArray<int32> Surfaces;
+		TArray<int32> Bounds;
+	};
+	TMap<FIntVector, FBucket> Buckets;
+	auto AddToBuckets = [this, &Buckets](const FBox& Bounds, int32 Index, TArray<int32> FBucket::*List)
+	{
+		const FIntVector MinCell = GetCellCoord(Bounds.Min);
+		const FIntVector MaxCell = GetCellCoord(Bounds.Max);
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+				{
+					(Buckets.FindOrAdd(FIntVector(X, Y, Z)).*List).Add(Index);
+				}
+			}
+		}
+	};
+	for (int32 SurfaceIndex = 0; SurfaceIndex < Surfaces.Num(); ++SurfaceIndex)
+	{
+		AddToBuckets(Surfaces[SurfaceIndex].GetBounds(), SurfaceIndex, &FBucket::Surfaces);
+	}
+	for (int32 BoundsIndex = 0; BoundsIndex < UncoveredBounds.Num(); ++BoundsIndex)
+	{
+		AddToBuckets(UncoveredBounds[BoundsIndex], BoundsIndex, &FBucket::Bounds);
+	}
+
+	Buckets.KeySort([](const FIntVector& A, const FIntVector& B)
+	{
+		return A.X != B.X ? A.X < B.X : (A.Y != B.Y ? A.Y < B.Y : A.Z < B.Z);
+	});
+
+	Cells.Reserve(Buckets.Num());
+	for (const TPair<FIntVector, FBucket>& Bucket : Buckets)
+	{
+		FTutWallRunSurfaceCell& Cell = Cells.AddDefaulted_GetRef();
+		Cell.Coord = Bucket.Key;
+		Cell.First = CellSurfaces.Num();
+		Cell.Num = Bucket.Value.Surfaces.Num();
+		CellSurfaces.Append(Bucket.Value.Surfaces);
+		Cell.FirstBounds = CellBounds.Num();
+		Cell.NumBounds = Bucket.Value.Bounds.Num();
+		CellBounds.Append(Bucket.Value.Bounds);
+	}
+
+	if (UncoveredBounds.Num() > 0)
+	{
+		UE_LOG(LogTutWallRunIndex, Log, TEXT("%d pieces of collision (landscapes, spheres and capsules, unreadable complex collision) are kept as bounds, and always traced near."), UncoveredBounds.Num());
+	}
+
+	BuildLookup();
+}
+
+bool UTutWallRunSurfaceIndex::AddCollision(UPrimitiveComponent& Component, const FTransform& Transform)
+{
+	//Landscapes, for one, have no body setup.
+	const UBodySetup* BodySetup = Component.GetBodySetup();
+	if (!BodySetup)
+	{
+		return false;
+	}
+
+	using namespace TutWallRunSurfaceIndex;
+
+	//Our traces don't trace complex, so they hit the simple shapes unless the body uses its triangles as its simple collision.
+	if (BodySetup->GetCollisionTraceFlag() == CTF_UseComplexAsSimple)
+	{
+		//Static meshes hand out their triangles through the mesh, BSP through the component itself.
+		const UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(&Component);
+		UObject* CollisionSource = MeshComponent ? static_cast<UObject*>(MeshComponent->GetStaticMesh()) : static_cast<UObject*>(&Component);
+		IInterface_CollisionDataProvider* TriMeshProvider = Cast<IInterface_CollisionDataProvider>(CollisionSource);
+		FTriMeshCollisionData TriMesh;
+		if (!TriMeshProvider || !TriMeshProvider->ContainsPhysicsTriMeshData(true) || !TriMeshProvider->GetPhysicsTriMeshData(&TriMesh, true))
+		{
+			UE_LOG(LogTutWallRunIndex, Warning, TEXT("%s uses complex collision we can't read, so only its bounds are indexed."), *Component.GetPathName());
+			return false;
+		}
+
+		FPlaneGroups Planes;
+		for (const FTriIndices& Triangle : TriMesh.Indices)
+		{
+			Planes.AddTriangle(
+				Transform.TransformPosition(FVector(TriMesh.Vertices[Triangle.v0])),
+				Transform.TransformPosition(FVector(TriMesh.Vertices[Triangle.v1])),
+				Transform.TransformPosition(FVector(TriMesh.Vertices[Triangle.v2])));
+		}
+		for (int32 Plane = 0; Plane < Planes.Normals.Num(); ++Plane)
+		{
+			AddFace(Planes.Normals[Plane], Planes.Points[Plane]);
+		}
+		return true;
+	}
+
+	const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+
+	for (const FKBoxElem& Box : AggGeom.BoxElems)
+	{
+		const FTransform BoxTransform = Box.GetTransform() * Transform;
+		const FVector HalfSize(Box.X * 0.5f, Box.Y * 0.5f, Box.Z * 0.5f);
+
+		//Six faces, two per axis.
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const int32 AxisU = (Axis + 1) % 3;
+			const int32 AxisV = (Axis + 2) % 3;
+			for (const float Side : { -1.f, 1.f })
+			{
+				FVector Corners[4];
+				for (int32 Corner = 0; Corner < 4; ++Corner)
+				{
+					FVector Local;
+					Local[Axis] = Side * HalfSize[Axis];
+					Local[AxisU] = (Corner & 1 ? 1.f : -1.f) * HalfSize[AxisU];
+					Local[AxisV] = (Corner & 2 ? 1.f : -1.f) * HalfSize[AxisV];
+					Corners[Corner] = BoxTransform.TransformPosition(Local);
+				}
+
+				//Worked out from the corners, so any scale on the component is accounted for.
+				const FVector Normal = ((Corners[1] - Corners[0]) ^ (Corners[2] - Corners[0])).GetSafeNormal();
+				if (!Normal.IsZero())
+				{
+					AddFace(Normal, Corners);
+				}
+			}
+		}
+	}
+
+	for (const FKConvexElem& Convex : AggGeom.ConvexElems)
+	{
+		const FTransform ConvexTransform = Convex.GetTransform() * Transform;
+
+		FPlaneGroups Planes;
+		for (int32 Index = 0; Index + 2 < Convex.IndexData.Num(); Index += 3)
+		{
+			Planes.AddTriangle(
+				ConvexTransform.TransformPosition(Convex.VertexData[Convex.IndexData[Index]]),
+				ConvexTransform.TransformPosition(Convex.VertexData[Convex.IndexData[Index + 1]]),
+				ConvexTransform.TransformPosition(Convex.VertexData[Convex.IndexData[Index + 2]]));
+		}
+		for (int32 Plane = 0; Plane < Planes.Normals.Num(); ++Plane)
+		{
+			AddFace(Planes.Normals[Plane], Planes.Points[Plane]);
+		}
+	}
+
+	//Spheres, capsules and the like have no flat faces to turn into surfaces, but a probe can still hit them and start a wall run.
+	return AggGeom.SphereElems.Num() == 0 && AggGeom.SphylElems.Num() == 0 && AggGeom.TaperedCapsuleElems.Num() == 0;
+}
+
+void UTutWallRunSurfaceIndex::AddFace(const FVector& Normal, TArrayView<const FVector> Points)
+{
+	//Which way the normal faces doesn't matter, the surface is a rectangle either way.
+	const FVector RunDirection = FVector(-Normal.Y, Normal.X, 0.f).GetSafeNormal();
+	if (Points.Num() == 0 || RunDirection.IsZero())
+	{
+		//Flat floors and ceilings. The side traces run parallel to them and can't hit them.
+		return;
+	}
+	const FVector Up = Normal ^ RunDirection;
+
+	const FVector Origin = Points[0];
+	FVector2D Min(0.f, 0.f);
+	FVector2D Max(0.f, 0.f);
+	double Depth = 0.0;
+	for (const FVector& Point : Points)
+	{
+		const FVector Delta = Point - Origin;
+		const FVector2D Projected(Delta | RunDirection, Delta | Up);
+		Min = Min.ComponentMin(Projected);
+		Max = Max.ComponentMax(Projected);
+		Depth += Delta | Normal;
+	}
+
+	FTutWallRunSurface& Surface = Surfaces.AddDefaulted_GetRef();
+	Surface.Normal = Normal;
+	Surface.RunDirection = RunDirection;
+	Surface.HalfExtent = (Max - Min) * 0.5f;
+	Surface.Center = Origin + RunDirection * ((Min.X + Max.X) * 0.5f) + Up * ((Min.Y + Max.Y) * 0.5f) + Normal * (Depth / Points.Num());
+}
+
+bool UTutWallRunSurfaceIndex::HasSurfaceNear(const FVector& Location, float Reach) const
+{
+	const float Radius = Reach + QueryMargin;
+	const float RadiusSquared = FMath::Square(Radius);
+	const FIntVector MinCell = GetCellCoord(Location - FVector(Radius));
+	const FIntVector MaxCell = GetCellCoord(Location + FVector(Radius));
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				const int32* CellIndex = CellLookup.Find(FIntVector(X, Y, Z));
+				if (!CellIndex)
+				{
+					continue;
+				}
+
+				const FTutWallRunSurfaceCell& Cell = Cells[*CellIndex];
+				for (int32 Entry = Cell.First; Entry < Cell.First + Cell.Num; ++Entry)
+				{
+					if (Surfaces[CellSurfaces[Entry]].GetDistanceSquared(Location) <= RadiusSquared)
+					{
+						return true;
+					}
+				}
+				for (int32 Entry = Cell.FirstBounds; Entry < Cell.FirstBounds + Cell.NumBounds; ++Entry)
+				{
+					if (UncoveredBounds[CellBounds[Entry]].ComputeSquaredDistanceToPoint(Location) <= RadiusSquared)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void UTutWallRunSurfaceIndex::BuildLookup()
+{
+	CellLookup.Reset();
+	CellLookup.Reserve(Cells.Num());
+	for (int32 CellIndex = 0; CellIndex < Cells.Num(); ++CellIndex)
+	{
+		CellLookup.Add(Cells[CellIndex].Coord, CellIndex);
+	}
+}
+
+void UTutWallRunSurfaceIndex::PostLoad()
+{
+	Super::PostLoad();
+	BuildLookup();
+}
+
+void UTutWallRunSurfaceIndex::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Surfaces.GetAllocatedSize() + UncoveredBounds.GetAllocatedSize() + Cells.GetAllocatedSize()
+		+ CellSurfaces.GetAllocatedSize() + CellBounds.GetAllocatedSize() + CellLookup.GetAllocatedSize());
+}
+
+#pragma endregion
+
+#pragma region Subsystem
+
+bool UTutWallRunSurfaceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTutWallRunSurfaceSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//Whatever the level placed is baked into the index, except what moves. Whatever is spawned from now on isn't baked at all.
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTutWallRunSurfaceSubsystem::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UTutWallRunSurfaceSubsystem::OnLevelAdded);
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		OnLevelAdded(Level, &InWorld);
+	}
+
+	//A tool may already have handed us one.
+	if (Index)
+	{
+		return;
+	}
+
+	const FString MapPackageName = UWorld::RemovePIEPrefix(InWorld.GetOutermost()->GetName());
+	const FString IndexPackageName = UTutWallRunSurfaceIndex::GetPackageNameForMap(MapPackageName);
+	if (!FPackageName::DoesPackageExist(IndexPackageName))
+	{
+		return;
+	}
+
+	const FString IndexObjectPath = IndexPackageName + TEXT(".") + FPackageName::GetShortName(IndexPackageName);
+	Index = LoadObject<UTutWallRunSurfaceIndex>(nullptr, *IndexObjectPath, nullptr, LOAD_NoWarn | LOAD_Quiet);
+	if (Index)
+	{
+		UE_LOG(LogTutWallRunIndex, Log, TEXT("Using wall run surface index %s: %d surfaces and %d uncovered bounds in %d cells."),
+			*IndexObjectPath, Index->GetNumSurfaces(), Index->GetNumUncoveredBounds(), Index->GetNumCells());
+	}
+}
+
+void UTutWallRunSurfaceSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	UntrackPrimitives([](const UPrimitiveComponent*) { return true; });
+
+	Super::Deinitialize();
+}
+
+const UTutWallRunSurfaceIndex* UTutWallRunSurfaceSubsystem::GetIndex() const
+{
+	return GTutUseWallRunSurfaceIndex ? Index.Get() : nullptr;
+}
+
+void UTutWallRunSurfaceSubsystem::SetIndex(UTutWallRunSurfaceIndex* InIndex)
+{
+	Index = InIndex;
+
+	UntrackPrimitives([](const UPrimitiveComponent* Primitive)
+	{
+		return !Primitive || Primitive->Mobility != EComponentMobility::Movable;
+	});
+}
+
+void UTutWallRunSurfaceSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (!Level || World != GetWorld())
+	{
+		return;
+	}
+
+	for (const AActor* Actor : Level->Actors)
+	{
+		//Actors spawned before play started, by the game mode for example, weren't in the level when it was baked either.
+		TrackPrimitives(Actor, Actor && !Actor->IsNetStartupActor());
+	}
+}
+
+void UTutWallRunSurfaceSubsystem::OnActorSpawned(AActor* Actor)
+{
+	UntrackPrimitives([](const UPrimitiveComponent* Primitive) { return !Primitive; });
+	TrackPrimitives(Actor, true);
+}
+
+void UTutWallRunSurfaceSubsystem::TrackPrimitives(const AActor* Actor, bool bIncludeStatic)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	//Other characters count. The probes hit them, and only the probing character itself is ignored (see HasUnindexedPrimitiveNear).
+	const ECollisionChannel Channel = FTutWallProbe::GetTraceChannel();
+	Actor->ForEachComponent<UPrimitiveComponent>(false, [this, Channel, bIncludeStatic](UPrimitiveComponent* Component)
+	{
+		if (!(bIncludeStatic || Component->Mobility == EComponentMobility::Movable)
+			|| !Component->IsQueryCollisionEnabled() || Component->GetCollisionResponseToChannel(Channel) != ECR_Block
+			|| UnindexedPrimitiveSlots.Contains(Component))
+		{
+			return;
+		}
+
+		FTutUnindexedPrimitive Tracked;
+		Tracked.Primitive = Component;
+		Tracked.TransformUpdatedHandle = Component->TransformUpdated.AddUObject(this, &UTutWallRunSurfaceSubsystem::OnPrimitiveTransformUpdated);
+		const int32 Slot = UnindexedPrimitives.Add(Tracked);
+		UnindexedPrimitiveSlots.Add(Component, Slot);
+		AddToGrid(Slot, Component->Bounds.GetBox());
+	});
+}
+
+void UTutWallRunSurfaceSubsystem::UntrackPrimitives(TFunctionRef<bool(const UPrimitiveComponent*)> ShouldRemove)
+{
+	for (auto It = UnindexedPrimitiveSlots.CreateIterator(); It; ++It)
+	{
+		const int32 Slot = It.Value();
+		UPrimitiveComponent* Primitive = UnindexedPrimitives[Slot].Primitive.Get();
+		if (!ShouldRemove(Primitive))
+		{
+			continue;
+		}
+
+		if (Primitive)
+		{
+			Primitive->TransformUpdated.Remove(UnindexedPrimitives[Slot].TransformUpdatedHandle);
+		}
+		RemoveFromGrid(Slot);
+		UnindexedPrimitives.RemoveAt(Slot);
+		It.RemoveCurrent();
+	}
+}
+
+void UTutWallRunSurfaceSubsystem::OnPrimitiveTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+	const int32* Slot = Primitive ? UnindexedPrimitiveSlots.Find(Primitive) : nullptr;
+	if (!Slot)
+	{
+		return;
+	}
+
+	//Most moves stay within the same cells.
+	const FTutUnindexedPrimitive& Tracked = UnindexedPrimitives[*Slot];
+	const FBox Bounds = Primitive->Bounds.GetBox();
+	if (GetGridCell(Bounds.Min) == Tracked.MinCell && GetGridCell(Bounds.Max) == Tracked.MaxCell)
+	{
+		return;
+	}
+
+	RemoveFromGrid(*Slot);
+	AddToGrid(*Slot, Bounds);
+}
+
+FIntVector UTutWallRunSurfaceSubsystem::GetGridCell(const FVector& Location)
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / GridCellSize),
+		FMath::FloorToInt(Location.Y / GridCellSize),
+		FMath::FloorToInt(Location.Z / GridCellSize));
+}
+
+void UTutWallRunSurfaceSubsystem::AddToGrid(int32 Slot, const FBox& Bounds)
+{
+	FTutUnindexedPrimitive& Tracked = UnindexedPrimitives[Slot];
+	Tracked.MinCell = GetGridCell(Bounds.Min);
+	Tracked.MaxCell = GetGridCell(Bounds.Max);
+
+	const FIntVector Span = Tracked.MaxCell - Tracked.MinCell + FIntVector(1);
+	Tracked.bInGrid = (int64)Span.X * Span.Y * Span.Z <= MaxGridCellsPerPrimitive;
+	if (!Tracked.bInGrid)
+	{
+		LargePrimitives.Add(Slot);
+		return;
+	}
+
+	for (int32 X = Tracked.MinCell.X; X <= Tracked.MaxCell.X; ++X)
+	{
+		for (int32 Y = Tracked.MinCell.Y; Y <= Tracked.MaxCell.Y; ++Y)
+		{
+			for (int32 Z = Tracked.MinCell.Z; Z <= Tracked.MaxCell.Z; ++Z)
+			{
+				Grid.FindOrAdd(FIntVector(X, Y, Z)).Add(Slot);
+			}
+		}
+	}
+}
+
+void UTutWallRunSurfaceSubsystem::RemoveFromGrid(int32 Slot)
+{
+	const FTutUnindexedPrimitive& Tracked = UnindexedPrimitives[Slot];
+	if (!Tracked.bInGrid)
+	{
+		LargePrimitives.RemoveSingleSwap(Slot, false);
+		return;
+	}
+
+	for (int32 X = Tracked.MinCell.X; X <= Tracked.MaxCell.X; ++X)
+	{
+		for (int32 Y = Tracked.MinCell.Y; Y <= Tracked.MaxCell.Y; ++Y)
+		{
+			for (int32 Z = Tracked.MinCell.Z; Z <= Tracked.MaxCell.Z; ++Z)
+			{
+				const FIntVector Cell(X, Y, Z);
+				if (TArray<int32, TInlineAllocator<4>>* Slots = Grid.Find(Cell))
+				{
+					Slots->RemoveSingleSwap(Slot, false);
+					if (Slots->Num() == 0)
+					{
+						Grid.Remove(Cell);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool UTutWallRunSurfaceSubsystem::HasUnindexedPrimitiveNear(const FVector& Location, float Reach, const FCollisionQueryParams& Params) const
+{
+	const float ReachSquared = FMath::Square(Reach);
+	const ECollisionChannel Channel = FTutWallProbe::GetTraceChannel();
+	auto IsNear = [this, &Location, ReachSquared, Channel, &Params](int32 Slot)
+	{
+		const UPrimitiveComponent* Primitive = UnindexedPrimitives[Slot].Primitive.Get();
+		if (!Primitive || !Primitive->IsRegistered() || Primitive->Bounds.GetBox().ComputeSquaredDistanceToPoint(Location) > ReachSquared
+			|| !Primitive->IsQueryCollisionEnabled() || Primitive->GetCollisionResponseToChannel(Channel) != ECR_Block)
+		{
+			return false;
+		}
+
+		const AActor* Owner = Primitive->GetOwner();
+		return !(Owner && Params.GetIgnoredActors().Contains(Owner->GetUniqueID())) && !Params.GetIgnoredComponents().Contains(Primitive->GetUniqueID());
+	};
+
+	for (const int32 Slot : LargePrimitives)
+	{
+		if (IsNear(Slot))
+		{
+			return true;
+		}
+	}
+
+	const FIntVector MinCell = GetGridCell(Location - FVector(Reach));
+	const FIntVector MaxCell = GetGridCell(Location + FVector(Reach));
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				if (const TArray<int32, TInlineAllocator<4>>* Slots = Grid.Find(FIntVector(X, Y, Z)))
+				{
+					for (const int32 Slot : *Slots)
+					{
+						if (IsNear(Slot))
+						{
+							return true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+#pragma endregion
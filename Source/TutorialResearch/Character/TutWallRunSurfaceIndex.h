@@ -0,0 +1,262 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "TutWallRunSurfaceIndex.generated.h"
+
+class UBodySetup;
+class ULevel;
+class UPrimitiveComponent;
+struct FCollisionQueryParams;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTutWallRunIndex, Log, All);
+
+/*
+* One flat, non-horizontal face of level collision that a side trace could hit, and so a wall run could happen on.
+* A rectangle centred on Center, spanning HalfExtent.X along RunDirection and HalfExtent.Y along Normal ^ RunDirection.
+*/
+USTRUCT()
+struct FTutWallRunSurface
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run Surface")
+	FVector Center = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run Surface")
+	FVector Normal = FVector::ForwardVector;
+
+	//Horizontal, along the face. A wall run goes this way or the opposite way.
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run Surface")
+	FVector RunDirection = FVector::RightVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run Surface")
+	FVector2D HalfExtent = FVector2D::ZeroVector;
+
+	FVector GetUpDirection() const { return Normal ^ RunDirection; }
+
+	//Distance from Location to the closest point of the rectangle.
+	float GetDistanceSquared(const FVector& Location) const;
+
+	FBox GetBounds() const;
+};
+
+//One grid cell: the surfaces touching it are CellSurfaces[First, First + Num), the uncovered bounds touching it CellBounds[FirstBounds, FirstBounds + NumBounds).
+USTRUCT()
+struct FTutWallRunSurfaceCell
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FIntVector Coord = FIntVector::ZeroValue;
+
+	UPROPERTY()
+	int32 First = 0;
+
+	UPROPERTY()
+	int32 Num = 0;
+
+	UPROPERTY()
+	int32 FirstBounds = 0;
+
+	UPROPERTY()
+	int32 NumBounds = 0;
+};
+
+//How UTutWallRunSurfaceIndex::Build lays out the index.
+USTRUCT()
+struct FTutWallRunSurfaceBuildSettings
+{
+	GENERATED_BODY()
+
+	//Grid cell size. Around the size of a typical wall keeps both the cell count and the surfaces per cell low.
+	UPROPERTY(EditAnywhere, Category = "Build")
+	float CellSize = 500.f;
+};
+
+/*
+* A baked index of the wall-runnable surfaces of a level, built by UTutWallRunIndexCommandlet.
+*
+* TryWallRun traces left and right of the capsule on every falling tick to discover walls, and on most maps most of those traces hit nothing.
+* With an index, it first asks whether any surface is within reach of the capsule at all. Only if one is does it trace, to confirm the wall is really there.
+* The query is a hash of the grid cell and a point to rectangle distance per surface in it, with no physics scene access.
+*
+* Only static and stationary collision is broken down into surfaces: boxes, convex hulls, and the triangles of meshes and BSP that use complex collision as simple.
+* Static collision we can't break down (landscapes, spheres and capsules, complex collision we can't read) is kept as its bounds instead,
+* and anywhere within reach of those bounds the probes trace as they would without an index.
+* Movable and runtime-spawned collision isn't baked at all. UTutWallRunSurfaceSubsystem tracks it while the game runs, and the probes trace near it too.
+* Rebuild the index whenever the level's static collision changes. A stale index hides new walls, though it can never cause a wall run on a wall that is gone,
+* since the traces still have the final word.
+*/
+UCLASS()
+class TUTORIALRESEARCH_API UTutWallRunSurfaceIndex : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	//The package the commandlet writes the index of MapPackageName to, and UTutWallRunSurfaceSubsystem loads it from.
+	static FString GetPackageNameForMap(const FString& MapPackageName);
+
+	//Scans every static primitive in World that blocks the wall probe channel, replacing what this index held.
+	void Build(const UWorld* World, const FTutWallRunSurfaceBuildSettings& InSettings);
+
+	/*
+	* True if any surface, or the bounds of any collision we couldn't break down, lies within Reach of Location,
+	* so a wall probe from there (see FTutWallProbe::ProbeForWallRun) might find a wall of the baked level.
+	* False means it can't, and there is no need to trace, unless something that isn't baked is nearby (see UTutWallRunSurfaceSubsystem).
+	*/
+	bool HasSurfaceNear(const FVector& Location, float Reach) const;
+
+	int32 GetNumSurfaces() const { return Surfaces.Num(); }
+	int32 GetNumUncoveredBounds() const { return UncoveredBounds.Num(); }
+	int32 GetNumCells() const { return Cells.Num(); }
+
+	virtual void PostLoad() override;
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	//The map this was built from.
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run Index")
+	FString MapName;
+
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run Index")
+	FTutWallRunSurfaceBuildSettings Settings;
+
+private:
+
+	//Tolerance added to every query, so surfaces that were rounded while baking aren't missed.
+	static constexpr float QueryMargin = 2.f;
+
+	FIntVector GetCellCoord(const FVector& Location) const;
+
+	//Rebuilds CellLookup from Cells.
+	void BuildLookup();
+
+	/*
+	* The collision a line trace against Component at Transform would hit: its simple shapes, or its triangles if it uses complex collision as simple.
+	* Returns false if some of it couldn't be broken down into surfaces, in which case the caller keeps the component's bounds instead.
+	*/
+	bool AddCollision(UPrimitiveComponent& Component, const FTransform& Transform);
+
+	/*
+	* A face of collision, as points on its plane. Every face a horizontal trace can hit is added, however small or steep:
+	* TryWallRun takes any blocking hit it isn't moving away from, so posts, pillars and ramps start wall runs as well.
+	*/
+	void AddFace(const FVector& Normal, TArrayView<const FVector> Points);
+
+	UPROPERTY()
+	TArray<FTutWallRunSurface> Surfaces;
+
+	//Sorted by Coord, so builds of the same level are identical.
+	UPROPERTY()
+	TArray<FTutWallRunSurfaceCell> Cells;
+
+	UPROPERTY()
+	TArray<int32> CellSurfaces;
+
+	//Bounds of static collision AddCollision couldn't break down. Queries near these always trace.
+	UPROPERTY()
+	TArray<FBox> UncoveredBounds;
+
+	UPROPERTY()
+	TArray<int32> CellBounds;
+
+	//Cell coordinate to index into Cells. Not saved, rebuilt on load.
+	TMap<FIntVector, int32> CellLookup;
+};
+
+//Collision UTutWallRunSurfaceSubsystem tracks because the index doesn't cover it, and the cells of its grid the collision's bounds touch.
+struct FTutUnindexedPrimitive
+{
+	TWeakObjectPtr<UPrimitiveComponent> Primitive;
+	FIntVector MinCell = FIntVector::ZeroValue;
+	FIntVector MaxCell = FIntVector::ZeroValue;
+	//False for collision too big to spread over the grid. It is kept in a list instead, and checked by every query.
+	bool bInGrid = false;
+	FDelegateHandle TransformUpdatedHandle;
+};
+
+/*
+* Holds the wall run surface index of the current world, if its map has one. Movement components ask it through GetIndex.
+* The index is found by name (see UTutWallRunSurfaceIndex::GetPackageNameForMap), so nothing references it. Make sure it gets cooked,
+* e.g. by adding its directory to "Additional Asset Directories to Cook" in the packaging settings. Without it, wall running simply traces as before.
+*
+* The index only knows the level as it was baked, so this also keeps track of the collision that isn't in it: movable components placed in the level
+* or a streamed in sublevel, and every component spawned at runtime (characters included), as long as it blocks the wall probes.
+* They are kept in a coarse grid of their own, and moved between its cells whenever their transform updates, so HasUnindexedPrimitiveNear only looks at
+* the few of them near the query. Collision that is switched on after its actor spawned isn't picked up.
+*
+* tut.Movement.WallRunSurfaceIndex=0 ignores the index, to compare against the traces alone.
+*/
+UCLASS()
+class TUTORIALRESEARCH_API UTutWallRunSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	//Null when there is no index, or it is turned off.
+	const UTutWallRunSurfaceIndex* GetIndex() const;
+
+	/*
+	* For tools that build an index at runtime, like the movement benchmark.
+	* The index is assumed to be built from this world as it is now, so the static components spawned so far are no longer tracked.
+	*/
+	void SetIndex(UTutWallRunSurfaceIndex* InIndex);
+
+	/*
+	* True if collision the index doesn't know about is within Reach of Location, so the probes have to trace whatever the index says.
+	* Collision of the actors and components Params ignores doesn't count, the probes can't hit it. That keeps the probing character's own capsule out.
+	*/
+	bool HasUnindexedPrimitiveNear(const FVector& Location, float Reach, const FCollisionQueryParams& Params) const;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	void OnActorSpawned(AActor* Actor);
+	//Streamed in levels, and every level of the world once play starts.
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	//Adds Actor's components that block the wall probes. Only the movable ones unless bIncludeStatic.
+	void TrackPrimitives(const AActor* Actor, bool bIncludeStatic);
+
+	//Stops tracking the primitives ShouldRemove returns true for. It is passed null for the destroyed ones.
+	void UntrackPrimitives(TFunctionRef<bool(const UPrimitiveComponent*)> ShouldRemove);
+
+	//Moves a tracked primitive to the cells its bounds touch now.
+	void OnPrimitiveTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	static FIntVector GetGridCell(const FVector& Location);
+	void AddToGrid(int32 Slot, const FBox& Bounds);
+	void RemoveFromGrid(int32 Slot);
+
+	//Around the reach of a wall probe, so a query touches a handful of cells at most.
+	static constexpr float GridCellSize = 500.f;
+
+	//Collision whose bounds touch more cells than this goes in LargePrimitives instead.
+	static constexpr int32 MaxGridCellsPerPrimitive = 64;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTutWallRunSurfaceIndex> Index;
+
+	//Collision the index doesn't cover. Destroyed components are dropped whenever more are added.
+	TSparseArray<FTutUnindexedPrimitive> UnindexedPrimitives;
+	TMap<TObjectKey<UPrimitiveComponent>, int32> UnindexedPrimitiveSlots;
+
+	//Grid cell to the slots in UnindexedPrimitives whose bounds touch it.
+	TMap<FIntVector, TArray<int32, TInlineAllocator<4>>> Grid;
+	TArray<int32> LargePrimitives;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+};
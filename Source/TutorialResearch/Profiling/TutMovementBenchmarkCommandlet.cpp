@@ -0,0 +1,276 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutMovementBenchmarkCommandlet.h"
+#include "../Character/MyCustomCharacter.h"
+#include "../Character/MyCustomAICharacter.h"
+#include "../Character/TutCharacterMovementComponent.h"
+#include "../Character/TutWallProbe.h"
+#include "../Character/TutMovementManagerSubsystem.h"
+#include "../Character/TutWallRunSurfaceIndex.h"
+#include "TutMovementScript.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Math/RandomStream.h"
+#include "UObject/CoreNet.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTutMovementBenchmark);
+
+UTutMovementBenchmarkCommandlet::UTutMovementBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UTutMovementBenchmarkCommandlet::Main(const FString& Params)
+{
+	FSettings Settings;
+	FParse::Value(*Params, TEXT("Characters="), Settings.NumCharacters);
+	FParse::Value(*Params, TEXT("Seconds="), Settings.Seconds);
+	FParse::Value(*Params, TEXT("TickRate="), Settings.TickRate);
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	Settings.bQuantize = FParse::Param(*Params, TEXT("Quantize"));
+	Settings.bDeltaEncode = FParse::Param(*Params, TEXT("DeltaEncode"));
+	Settings.bAsyncProbes = FParse::Param(*Params, TEXT("AsyncProbes"));
+	Settings.bBatched = FParse::Param(*Params, TEXT("Batched"));
+	Settings.bAIMovement = FParse::Param(*Params, TEXT("AIMovement"));
+	Settings.bSurfaceIndex = FParse::Param(*Params, TEXT("SurfaceIndex"));
+	Settings.bParallelWallProbes = Settings.bBatched && FParse::Param(*Params, TEXT("ParallelWallProbes"));
+
+	Settings.NumCharacters = FMath::Clamp(Settings.NumCharacters, 1, 1000);
+	Settings.TickRate = FMath::Clamp(Settings.TickRate, 10.f, 240.f);
+	Settings.Seconds = FMath::Max(Settings.Seconds, 1.f);
+
+	const float DeltaSeconds = 1.f / Settings.TickRate;
+	const int32 NumTicks = FMath::CeilToInt(Settings.Seconds * Settings.TickRate) + Settings.WarmupTicks;
+
+	/*
+	* We own this world entirely. There is no game mode or player controller, we tick it by hand, and we tick the movement components ourselves so we can time them.
+	* It is a standalone world, so every character has authority and runs the same code a server runs for its own AI characters.
+	*/
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("TutMovementBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->GetWorldSettings()->NotifyBeginPlay();
+
+	//Nothing ticks the manager in this world but us, see the tick loop.
+	UTutMovementManagerSubsystem* Manager = World->GetSubsystem<UTutMovementManagerSubsystem>();
+	if (Settings.bBatched && !Manager)
+	{
+		UE_LOG(LogTutMovementBenchmark, Error, TEXT("-Batched needs UTutMovementManagerSubsystem, which doesn't exist in this world."));
+		Settings.bBatched = false;
+		Settings.bParallelWallProbes = false;
+	}
+	if (IConsoleVariable* ParallelWallProbesCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("tut.Movement.ParallelWallProbes")))
+	{
+		ParallelWallProbesCVar->Set(Settings.bParallelWallProbes);
+	}
+
+	//Fastest sprint tier, with some room to spare, for the whole run.
+	const float LaneLength = 1200.f * Settings.Seconds + 2000.f;
+	FTutWallCourse::Build(World, FVector::ZeroVector, Settings.NumCharacters, -500.f, LaneLength - 500.f, Settings.Seed);
+
+	//What UTutWallRunIndexCommandlet would bake for a real map, built from the course instead.
+	UTutWallRunSurfaceSubsystem* WallRunSurfaces = World->GetSubsystem<UTutWallRunSurfaceSubsystem>();
+	if (Settings.bSurfaceIndex && WallRunSurfaces)
+	{
+		const double BuildStartSeconds = FPlatformTime::Seconds();
+		UTutWallRunSurfaceIndex* SurfaceIndex = NewObject<UTutWallRunSurfaceIndex>(GetTransientPackage());
+		SurfaceIndex->Build(World, FTutWallRunSurfaceBuildSettings());
+		WallRunSurfaces->SetIndex(SurfaceIndex);
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("Built a wall run surface index of %d surfaces in %d cells in %.1f ms."),
+			SurfaceIndex->GetNumSurfaces(), SurfaceIndex->GetNumCells(), (FPlatformTime::Seconds() - BuildStartSeconds) * 1000.0);
+	}
+	else if (Settings.bSurfaceIndex)
+	{
+		UE_LOG(LogTutMovementBenchmark, Error, TEXT("-SurfaceIndex needs UTutWallRunSurfaceSubsystem, which doesn't exist in this world."));
+		Settings.bSurfaceIndex = false;
+	}
+
+	FRandomStream Random(Settings.Seed);
+	TArray<AMyCustomCharacter*> Characters;
+	TArray<float> PhaseOffsets;
+	for (int32 Index = 0; Index < Settings.NumCharacters; ++Index)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		const FVector SpawnLocation = FTutWallCourse::GetLaneStart(FVector::ZeroVector, Index);
+		UClass* CharacterClass = Settings.bAIMovement ? AMyCustomAICharacter::StaticClass() : AMyCustomCharacter::StaticClass();
+		AMyCustomCharacter* Character = World->SpawnActor<AMyCustomCharacter>(CharacterClass, SpawnLocation, FRotator::ZeroRotator, SpawnParams);
+		if (!Character)
+		{
+			UE_LOG(LogTutMovementBenchmark, Error, TEXT("Failed to spawn character %d."), Index);
+			continue;
+		}
+
+		UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+		Movement->bRunPhysicsWithNoController = true;
+		Movement->MoveDataQuantization.bQuantizeMoveData = Settings.bQuantize;
+		Movement->bDeltaEncodeMoveData = Settings.bDeltaEncode;
+		Movement->bUseAsyncWallProbes = Settings.bAsyncProbes;
+		//The AI component registers itself with the manager. Without -Batched we want it ticked one at a time like the rest.
+		if (Settings.bBatched)
+		{
+			Movement->bUseMovementManager = true;
+			Manager->Register(Movement);
+		}
+		else if (Manager)
+		{
+			Manager->Unregister(Movement);
+		}
+		//We tick it ourselves below.
+		Movement->SetComponentTickEnabled(false);
+
+		Characters.Add(Character);
+		PhaseOffsets.Add(Random.FRandRange(0.f, FTutMovementScript::CycleSeconds));
+	}
+
+	UE_LOG(LogTutMovementBenchmark, Display, TEXT("Running %d characters for %d ticks at %.0f Hz (Quantize=%d DeltaEncode=%d AsyncProbes=%d Batched=%d ParallelWallProbes=%d AIMovement=%d SurfaceIndex=%d)."),
+		Characters.Num(), NumTicks, Settings.TickRate, Settings.bQuantize, Settings.bDeltaEncode, Settings.bAsyncProbes, Settings.bBatched, Settings.bParallelWallProbes, Settings.bAIMovement, Settings.bSurfaceIndex);
+
+	//What each of these characters costs a client that sees it: the component, plus the prediction data a simulated proxy allocates for smoothing.
+	SIZE_T MovementBytes = 0;
+	for (AMyCustomCharacter* Character : Characters)
+	{
+		UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+		Movement->GetPredictionData_Client();
+		MovementBytes += Movement->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+	const double MovementBytesPerCharacter = Characters.Num() > 0 ? double(MovementBytes) / Characters.Num() : 0.0;
+
+	TArray<double> TickMicroseconds;
+	TickMicroseconds.Reserve(Characters.Num() * (NumTicks - Settings.WarmupTicks));
+	TArray<FCustomNetworkMoveData> PreviousMoves;
+	PreviousMoves.SetNum(Characters.Num());
+
+	uint64 TotalTraces = 0;
+	uint64 TotalMoveBits = 0;
+	uint64 NumMoves = 0;
+	int32 SprintingSamples = 0, WallRunSamples = 0, FlyingSamples = 0, FallingSamples = 0;
+
+	for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+	{
+		const bool bMeasure = Tick >= Settings.WarmupTicks;
+		const float Time = Tick * DeltaSeconds;
+
+		for (int32 Index = 0; Index < Characters.Num(); ++Index)
+		{
+			const float Phase = FMath::Fmod(Time + PhaseOffsets[Index], FTutMovementScript::CycleSeconds);
+			//Nothing is triggered on the very first tick, everyone starts mid-cycle.
+			const float PreviousPhase = Tick == 0 ? Phase : FMath::Fmod(Time - DeltaSeconds + PhaseOffsets[Index], FTutMovementScript::CycleSeconds);
+			FTutMovementScript::Apply(Characters[Index], PreviousPhase, Phase, FVector::ForwardVector);
+		}
+
+		//Everything else: character ticks, timers, async traces.
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+
+		if (Settings.bBatched)
+		{
+			const uint64 TracesBefore = FTutWallProbe::GetTraceCount();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Manager->TickManaged(DeltaSeconds);
+			const uint64 EndCycles = FPlatformTime::Cycles64();
+
+			if (bMeasure)
+			{
+				//One sample per character, so the mean and the total per tick compare directly with per-component ticking.
+				const double PerCharacter = FPlatformTime::ToMilliseconds64(EndCycles - StartCycles) * 1000.0 / Characters.Num();
+				for (int32 Index = 0; Index < Characters.Num(); ++Index)
+				{
+					TickMicroseconds.Add(PerCharacter);
+				}
+				TotalTraces += FTutWallProbe::GetTraceCount() - TracesBefore;
+			}
+		}
+
+		for (int32 Index = 0; Index < Characters.Num(); ++Index)
+		{
+			AMyCustomCharacter* Character = Characters[Index];
+			UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+
+			if (!Settings.bBatched)
+			{
+				const uint64 TracesBefore = FTutWallProbe::GetTraceCount();
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				Movement->TickComponent(DeltaSeconds, LEVELTICK_All, &Movement->PrimaryComponentTick);
+				const uint64 EndCycles = FPlatformTime::Cycles64();
+
+				if (bMeasure)
+				{
+					TickMicroseconds.Add(FPlatformTime::ToMilliseconds64(EndCycles - StartCycles) * 1000.0);
+					TotalTraces += FTutWallProbe::GetTraceCount() - TracesBefore;
+				}
+			}
+
+			if (!bMeasure)
+			{
+				continue;
+			}
+
+			SprintingSamples += Movement->bIsSprinting;
+			WallRunSamples += Movement->IsWallRunning();
+			FlyingSamples += Movement->IsFlying();
+			FallingSamples += Movement->IsFalling();
+
+			/*
+			* What this tick's New move would cost on the wire. We fill the move data straight from the component instead of going through a saved move.
+			* The movement base is left out, as it is sent as a net GUID which needs a real package map. That adds a few bytes whenever the character stands on something.
+			* Delta encoding is measured as if every move was acknowledged right away, which is the best case.
+			*/
+			FCustomNetworkMoveData MoveData;
+			MoveData.TimeStamp = World->GetTimeSeconds();
+			MoveData.Acceleration = Movement->GetCurrentAcceleration();
+			MoveData.Location = Movement->UpdatedComponent->GetComponentLocation();
+			MoveData.ControlRotation = Character->GetControlRotation();
+			MoveData.MovementMode = Movement->PackNetworkMovementMode();
+			MoveData.bWantsToSprintMoveData = Movement->bWantsToSprint;
+			MoveData.LaunchVelocityCustomMoveData = Movement->LaunchVelocityCustom;
+			MoveData.MovementFlagCustomMoveData = Movement->MovementFlagCustom;
+			MoveData.DeltaBaseline = Settings.bDeltaEncode ? &PreviousMoves[Index] : nullptr;
+
+			FNetBitWriter Writer(nullptr, 1024);
+			MoveData.Serialize(*Movement, Writer, nullptr, ENetworkMoveType::NewMove);
+			TotalMoveBits += Writer.GetNumBits();
+			++NumMoves;
+
+			MoveData.DeltaBaseline = nullptr;
+			PreviousMoves[Index] = MoveData;
+		}
+	}
+
+	const int32 NumMeasuredTicks = NumTicks - Settings.WarmupTicks;
+	const int32 NumSamples = TickMicroseconds.Num();
+	if (NumSamples > 0)
+	{
+		double TotalMicroseconds = 0.0;
+		for (const double Sample : TickMicroseconds)
+		{
+			TotalMicroseconds += Sample;
+		}
+		TickMicroseconds.Sort();
+		const double Mean = TotalMicroseconds / NumSamples;
+		const double P99 = TickMicroseconds[FMath::Min(NumSamples - 1, FMath::FloorToInt(NumSamples * 0.99))];
+		const double Percent = 100.0 / NumSamples;
+
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("Movement tick per character: mean %.2f us, p99 %.2f us, max %.2f us."), Mean, P99, TickMicroseconds.Last());
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("Movement tick for all characters: %.1f us per tick."), TotalMicroseconds / NumMeasuredTicks);
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("Wall probe traces: %.2f per tick, %.3f per character per tick."), double(TotalTraces) / NumMeasuredTicks, double(TotalTraces) / NumSamples);
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("New move data per ServerMove: %.1f bits (%.2f bytes)."), double(TotalMoveBits) / NumMoves, double(TotalMoveBits) / NumMoves / 8.0);
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("Movement component memory: %.0f bytes per character, with client prediction data."), MovementBytesPerCharacter);
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("Coverage: sprinting %.1f%%, wall running %.1f%%, flying %.1f%%, falling %.1f%%."),
+			SprintingSamples * Percent, WallRunSamples * Percent, FlyingSamples * Percent, FallingSamples * Percent);
+
+		//One line to grep for and diff between runs.
+		UE_LOG(LogTutMovementBenchmark, Display, TEXT("TutMovementBenchmark Characters=%d Ticks=%d Batched=%d ParallelWallProbes=%d AIMovement=%d SurfaceIndex=%d MeanUs=%.2f P99Us=%.2f TracesPerTick=%.2f MoveBits=%.1f MovementBytes=%.0f"),
+			Characters.Num(), NumMeasuredTicks, Settings.bBatched, Settings.bParallelWallProbes, Settings.bAIMovement, Settings.bSurfaceIndex, Mean, P99, double(TotalTraces) / NumMeasuredTicks, double(TotalMoveBits) / NumMoves, MovementBytesPerCharacter);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return NumSamples > 0 ? 0 : 1;
+}
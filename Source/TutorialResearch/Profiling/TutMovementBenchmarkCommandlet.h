@@ -0,0 +1,60 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TutMovementBenchmarkCommandlet.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTutMovementBenchmark, Log, All);
+
+/*
+* Headless throughput benchmark for UTutCharacterMovementComponent.
+* Spawns N AMyCustomCharacters on a generated wall course and drives them with scripted input covering sprinting, speed tiers, wall running, the fly flag and launches.
+* Reports the movement tick cost per character (mean and p99), wall probe traces per tick, and the size of the move data each ServerMove would carry.
+*
+* Usage (editor or server binary, no rendering needed):
+* UnrealEditor-Cmd TutorialResearch.uproject -run=TutMovementBenchmark -nullrhi -unattended -Characters=200 -Seconds=20
+*
+* Optional switches:
+* -Characters=N (1 to 1000), -Seconds=S, -TickRate=Hz, -Seed=N
+* -Quantize, -DeltaEncode, -AsyncProbes to flip the matching movement component options, so each can be compared against the defaults.
+* -Batched ticks every character through UTutMovementManagerSubsystem instead of one component at a time. The whole batch is timed,
+*  so the per character numbers are the batch time divided by the number of characters, and p99 is over ticks rather than characters.
+* -AIMovement spawns AMyCustomAICharacter (UTutAIMovementComponent) instead. There is no navmesh here, so it never probes for walls, which is the point:
+*  compare the wall probe traces and tick cost, and the memory per component, against the default.
+* -ParallelWallProbes, with -Batched, also sets tut.Movement.ParallelWallProbes so the manager runs wall probes on worker threads.
+* -SurfaceIndex builds a UTutWallRunSurfaceIndex of the course before the run, so TryWallRun only traces where a wall is within reach.
+*
+* Returns 0 on success. Run the same settings before and after a change and compare the summary lines.
+*/
+UCLASS()
+class UTutMovementBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UTutMovementBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	struct FSettings
+	{
+		int32 NumCharacters = 100;
+		float Seconds = 20.f;
+		float TickRate = 60.f;
+		int32 Seed = 1337;
+		//Ticks at the start we don't measure, while everyone lands and gets up to speed.
+		int32 WarmupTicks = 30;
+		bool bQuantize = false;
+		bool bDeltaEncode = false;
+		bool bAsyncProbes = false;
+		bool bBatched = false;
+		bool bParallelWallProbes = false;
+		bool bAIMovement = false;
+		bool bSurfaceIndex = false;
+	};
+};
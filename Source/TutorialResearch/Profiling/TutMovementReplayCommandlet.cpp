@@ -0,0 +1,293 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutMovementReplayCommandlet.h"
+#include "../Character/MyCustomCharacter.h"
+#include "../Character/TutCharacterMovementComponent.h"
+#include "../Character/TutMovementRecording.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY(LogTutMovementReplay);
+
+namespace TutMovementReplay
+{
+	//Where the character is after each frame. This is what baselines store and compare.
+	struct FFrameResult
+	{
+		FVector Location = FVector::ZeroVector;
+		uint8 MovementMode = 0;
+		uint8 CustomMovementMode = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FFrameResult& Result)
+		{
+			return Ar << Result.Location << Result.MovementMode << Result.CustomMovementMode;
+		}
+	};
+
+	static constexpr uint32 BaselineMagic = 0x42525554; //"TURB"
+
+	static bool SerializeBaseline(FArchive& Ar, TArray<FFrameResult>& Results, double& MeanMicroseconds)
+	{
+		uint32 Magic = BaselineMagic;
+		Ar << Magic;
+		if (Magic != BaselineMagic)
+		{
+			return false;
+		}
+		Ar << MeanMicroseconds << Results;
+		return !Ar.IsError();
+	}
+
+	//An empty map name gives an empty world, for recordings made somewhere we can't load.
+	static UWorld* CreateReplayWorld(const FString& MapName)
+	{
+		if (MapName.IsEmpty())
+		{
+			return UWorld::CreateWorld(EWorldType::Game, false, TEXT("TutMovementReplay"));
+		}
+
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (!World)
+		{
+			return nullptr;
+		}
+
+		World->WorldType = EWorldType::Game;
+		World->AddToRoot();
+		if (!World->bIsWorldInitialized)
+		{
+			World->InitWorld(UWorld::InitializationValues()
+				.AllowAudioPlayback(false)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.CreateFXSystem(false)
+				.SetTransactional(false));
+		}
+		World->UpdateWorldComponents(true, false);
+		return World;
+	}
+}
+
+UTutMovementReplayCommandlet::UTutMovementReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UTutMovementReplayCommandlet::Main(const FString& Params)
+{
+	using namespace TutMovementReplay;
+
+	FString RecordingName;
+	FString BaselineFilename;
+	int32 NumRepeats = 1;
+	float Tolerance = 0.1f;
+	FParse::Value(*Params, TEXT("Recording="), RecordingName);
+	FParse::Value(*Params, TEXT("Baseline="), BaselineFilename);
+	FParse::Value(*Params, TEXT("Repeat="), NumRepeats);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	NumRepeats = FMath::Max(NumRepeats, 1);
+
+	const FString RecordingFilename = FTutMovementRecording::ResolveFilename(RecordingName);
+	TSharedRef<FTutMovementRecording> Recording = MakeShared<FTutMovementRecording>();
+	if (RecordingName.IsEmpty() || !Recording->LoadFromFile(RecordingFilename))
+	{
+		UE_LOG(LogTutMovementReplay, Error, TEXT("Couldn't load a recording from '%s'. Pass -Recording=<name or path>."), *RecordingFilename);
+		return 2;
+	}
+
+	FString MapName = Recording->MapName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+
+	UClass* CharacterClass = LoadClass<AMyCustomCharacter>(nullptr, *Recording->CharacterClassPath);
+	if (!CharacterClass)
+	{
+		UE_LOG(LogTutMovementReplay, Warning, TEXT("Couldn't load character class '%s', using AMyCustomCharacter."), *Recording->CharacterClassPath);
+		CharacterClass = AMyCustomCharacter::StaticClass();
+	}
+
+	//Set up like the benchmark: a world we tick by hand, with the movement component ticked separately so it can be timed on its own.
+	UWorld* World = CreateReplayWorld(MapName);
+	if (!World)
+	{
+		UE_LOG(LogTutMovementReplay, Error, TEXT("Couldn't load map '%s'. Pass -Map= to replay somewhere else."), *MapName);
+		return 2;
+	}
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->GetWorldSettings()->NotifyBeginPlay();
+
+	const int32 NumFrames = Recording->Frames.Num();
+	UE_LOG(LogTutMovementReplay, Display, TEXT("Replaying %d frames of %s on %s, %d times."), NumFrames, *RecordingFilename, *MapName, NumRepeats);
+
+	TArray<FFrameResult> Results;
+	Results.Reserve(NumFrames);
+	TArray<double> FrameMicroseconds;
+	FrameMicroseconds.Reserve(NumFrames * NumRepeats);
+	double SimulatedSeconds = 0.0;
+	int32 NumRepeatMismatches = 0;
+
+	for (int32 Repeat = 0; Repeat < NumRepeats; ++Repeat)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AMyCustomCharacter* Character = World->SpawnActor<AMyCustomCharacter>(CharacterClass, Recording->StartState.Location, Recording->StartState.Rotation, SpawnParams);
+		if (!Character)
+		{
+			UE_LOG(LogTutMovementReplay, Error, TEXT("Failed to spawn the character."));
+			break;
+		}
+
+		UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+		Movement->bRunPhysicsWithNoController = true;
+		Movement->SetComponentTickEnabled(false);
+		Recording->StartState.Apply(*Movement);
+		Movement->StartInputReplay(Recording);
+
+		for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const float DeltaSeconds = Recording->Frames[FrameIndex].DeltaSeconds;
+			World->Tick(LEVELTICK_All, DeltaSeconds);
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Movement->TickComponent(DeltaSeconds, LEVELTICK_All, &Movement->PrimaryComponentTick);
+			FrameMicroseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0);
+
+			FFrameResult Result;
+			Result.Location = Movement->UpdatedComponent->GetComponentLocation();
+			Result.MovementMode = Movement->MovementMode;
+			Result.CustomMovementMode = Movement->CustomMovementMode;
+
+			if (Repeat == 0)
+			{
+				SimulatedSeconds += DeltaSeconds;
+				Results.Add(Result);
+			}
+			else if (!Results[FrameIndex].Location.Equals(Result.Location, 0.f) || Results[FrameIndex].MovementMode != Result.MovementMode)
+			{
+				++NumRepeatMismatches;
+			}
+		}
+
+		Character->Destroy();
+	}
+
+	bool bDiverged = NumRepeatMismatches > 0;
+	if (bDiverged)
+	{
+		UE_LOG(LogTutMovementReplay, Error, TEXT("Repeats of the same replay gave different results on %d frames. Something in the movement isn't deterministic."), NumRepeatMismatches);
+	}
+
+	double Mean = 0.0;
+	double P99 = 0.0;
+	if (FrameMicroseconds.Num() > 0)
+	{
+		for (const double Sample : FrameMicroseconds)
+		{
+			Mean += Sample;
+		}
+		Mean /= FrameMicroseconds.Num();
+		FrameMicroseconds.Sort();
+		P99 = FrameMicroseconds[FMath::Min(FrameMicroseconds.Num() - 1, FMath::FloorToInt(FrameMicroseconds.Num() * 0.99))];
+
+		UE_LOG(LogTutMovementReplay, Display, TEXT("Movement tick per frame: mean %.2f us, p99 %.2f us, max %.2f us."), Mean, P99, FrameMicroseconds.Last());
+	}
+
+	float EndError = -1.f;
+	if (Results.Num() > 0)
+	{
+		const FFrameResult& Last = Results.Last();
+		EndError = FVector::Dist(Last.Location, Recording->EndState.Location);
+		UE_LOG(LogTutMovementReplay, Display, TEXT("Replayed %.1f seconds. Ended %.2f cm from the live session, in mode %d/%d (live session %d/%d)."),
+			SimulatedSeconds, EndError, Last.MovementMode, Last.CustomMovementMode, Recording->EndState.MovementMode, Recording->EndState.CustomMovementMode);
+	}
+
+	int32 FirstDivergedFrame = INDEX_NONE;
+	if (!BaselineFilename.IsEmpty() && Results.Num() > 0)
+	{
+		TArray<uint8> Bytes;
+		if (FFileHelper::LoadFileToArray(Bytes, *BaselineFilename, FILEREAD_Silent))
+		{
+			TArray<FFrameResult> BaselineResults;
+			double BaselineMean = 0.0;
+			FMemoryReader Reader(Bytes);
+			if (!SerializeBaseline(Reader, BaselineResults, BaselineMean))
+			{
+				UE_LOG(LogTutMovementReplay, Error, TEXT("%s isn't a replay baseline."), *BaselineFilename);
+				bDiverged = true;
+			}
+			else
+			{
+				for (int32 FrameIndex = 0; FrameIndex < FMath::Max(Results.Num(), BaselineResults.Num()); ++FrameIndex)
+				{
+					if (!BaselineResults.IsValidIndex(FrameIndex) || !Results.IsValidIndex(FrameIndex)
+						|| !Results[FrameIndex].Location.Equals(BaselineResults[FrameIndex].Location, Tolerance)
+						|| Results[FrameIndex].MovementMode != BaselineResults[FrameIndex].MovementMode
+						|| Results[FrameIndex].CustomMovementMode != BaselineResults[FrameIndex].CustomMovementMode)
+					{
+						FirstDivergedFrame = FrameIndex;
+						break;
+					}
+				}
+
+				if (FirstDivergedFrame != INDEX_NONE)
+				{
+					bDiverged = true;
+					if (Results.IsValidIndex(FirstDivergedFrame) && BaselineResults.IsValidIndex(FirstDivergedFrame))
+					{
+						const FFrameResult& Ours = Results[FirstDivergedFrame];
+						const FFrameResult& Theirs = BaselineResults[FirstDivergedFrame];
+						UE_LOG(LogTutMovementReplay, Error, TEXT("Diverged from the baseline at frame %d: %s mode %d/%d, baseline %s mode %d/%d."),
+							FirstDivergedFrame, *Ours.Location.ToString(), Ours.MovementMode, Ours.CustomMovementMode, *Theirs.Location.ToString(), Theirs.MovementMode, Theirs.CustomMovementMode);
+					}
+					else
+					{
+						UE_LOG(LogTutMovementReplay, Error, TEXT("The baseline has %d frames, this replay has %d."), BaselineResults.Num(), Results.Num());
+					}
+				}
+				else
+				{
+					UE_LOG(LogTutMovementReplay, Display, TEXT("Matches the baseline on every frame."));
+				}
+
+				if (BaselineMean > 0.0)
+				{
+					UE_LOG(LogTutMovementReplay, Display, TEXT("Mean movement tick %.2f us, baseline %.2f us (%+.1f%%)."), Mean, BaselineMean, (Mean / BaselineMean - 1.0) * 100.0);
+				}
+			}
+		}
+		else
+		{
+			TArray<uint8> BaselineBytes;
+			FMemoryWriter Writer(BaselineBytes);
+			SerializeBaseline(Writer, Results, Mean);
+			if (FFileHelper::SaveArrayToFile(BaselineBytes, *BaselineFilename))
+			{
+				UE_LOG(LogTutMovementReplay, Display, TEXT("Saved a new baseline to %s"), *BaselineFilename);
+			}
+		}
+	}
+
+	//One line to grep for and diff between runs.
+	UE_LOG(LogTutMovementReplay, Display, TEXT("TutMovementReplay Frames=%d Repeats=%d MeanUs=%.2f P99Us=%.2f EndErrorCm=%.2f DivergedFrame=%d"),
+		NumFrames, NumRepeats, Mean, P99, EndError, FirstDivergedFrame);
+
+	World->RemoveFromRoot();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	if (Results.Num() == 0)
+	{
+		return 2;
+	}
+	return bDiverged ? 1 : 0;
+}
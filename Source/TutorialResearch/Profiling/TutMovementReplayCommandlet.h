@@ -0,0 +1,39 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TutMovementReplayCommandlet.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTutMovementReplay, Log, All);
+
+/*
+* Replays a recorded movement input session (see TutMovementRecording.h) headless, as fast as the machine allows.
+* Loads the map and character class it was recorded with, puts the character where the recording started and feeds every recorded frame with its original DeltaSeconds.
+*
+* Usage:
+* UnrealEditor-Cmd TutorialResearch.uproject -run=TutMovementReplay -nullrhi -unattended -Recording=MySession
+*
+* Optional switches:
+* -Map=/Game/... to replay on a different map than the one recorded.
+* -Repeat=N to replay N times for steadier timings. Every repeat must end in the same place, otherwise the replay isn't deterministic and the run fails.
+* -Baseline=File. If the file doesn't exist, the position and mode after every frame is saved to it. If it does, every frame is compared against it,
+*  and the first frame that differs is reported. Save a baseline with one build and compare against it with the next to catch behaviour changes.
+* -Tolerance=cm for the baseline comparison, 0.1 by default.
+*
+* Reports the movement tick cost per frame (mean and p99) and how far the replay ended from where the live session did.
+* The live session ran through prediction, corrections and move combining, so a small difference there is expected. Differences between builds are not.
+* Returns 0 on success, 1 if the replay diverged from the baseline or between repeats, 2 if it couldn't run.
+*/
+UCLASS()
+class UTutMovementReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UTutMovementReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
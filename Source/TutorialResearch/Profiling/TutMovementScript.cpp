@@ -0,0 +1,108 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutMovementScript.h"
+#include "../Character/MyCustomCharacter.h"
+#include "../Character/TutCharacterMovementComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "Engine/CollisionProfile.h"
+#include "Math/RandomStream.h"
+
+void FTutMovementScript::Apply(AMyCustomCharacter* Character, float PreviousPhase, float Phase, const FVector& RunDirection)
+{
+	UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+
+	//Returns true on the tick we pass this point in the cycle.
+	auto Crossed = [PreviousPhase, Phase](float Point)
+	{
+		return PreviousPhase <= Phase ? (PreviousPhase < Point && Point <= Phase) : (PreviousPhase < Point || Point <= Phase);
+	};
+
+	//Always run down the lane.
+	Character->AddMovementInput(RunDirection);
+
+	//0-5s: sprint, switching speed tier halfway through.
+	Movement->bWantsToSprint = Phase < 5.f;
+	if (Crossed(0.f))
+	{
+		Movement->SetSpeedTier(0);
+	}
+	if (Crossed(2.5f) && Movement->SpeedTiers.Num() > 1)
+	{
+		Movement->SetSpeedTier(1);
+	}
+
+	//Jumps while running next to the walls start wall runs. Jumping again during one is a wall jump.
+	if (Crossed(1.f) || Crossed(3.f) || Crossed(3.4f))
+	{
+		Character->Jump();
+	}
+	if (Crossed(1.2f) || Crossed(3.2f) || Crossed(3.6f))
+	{
+		Character->StopJumping();
+	}
+
+	//5-6s: fly.
+	if (Crossed(5.f))
+	{
+		Movement->ActivateMovementFlag((uint8)EMovementFlag::CFLAG_WantsToFly);
+	}
+	if (Crossed(6.f))
+	{
+		Movement->ClearMovementFlag((uint8)EMovementFlag::CFLAG_WantsToFly);
+	}
+
+	//7s: launch forwards and up.
+	if (Crossed(7.f))
+	{
+		Movement->LaunchCharacterReplicated(RunDirection * 400.f + FVector(0.f, 0.f, 600.f), false, false);
+	}
+}
+
+AActor* FTutWallCourse::Build(UWorld* World, const FVector& Origin, int32 NumLanes, float LaneMinX, float LaneMaxX, int32 Seed)
+{
+	AActor* Course = World->SpawnActor<AActor>();
+	const float CapsuleRadius = GetDefault<AMyCustomCharacter>()->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
+	//Walls sit just inside the range TryWallRun probes to the side (twice the capsule radius).
+	const float WallOffset = CapsuleRadius * 1.5f;
+	const float WallThickness = 20.f;
+	const float WallHeight = 600.f;
+	const float LaneLength = LaneMaxX - LaneMinX;
+
+	auto AddBox = [World, Course](const FVector& Center, const FVector& Extent)
+	{
+		UBoxComponent* Box = NewObject<UBoxComponent>(Course);
+		Box->SetMobility(EComponentMobility::Static);
+		Box->SetBoxExtent(Extent, false);
+		Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Box->SetWorldLocation(Center);
+		Box->RegisterComponentWithWorld(World);
+	};
+
+	FRandomStream Random(Seed);
+	for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+	{
+		const FVector LaneOrigin = Origin + FVector(0.f, Lane * LaneSpacing, 0.f);
+		AddBox(LaneOrigin + FVector(LaneMinX + LaneLength * 0.5f, 0.f, -50.f), FVector(LaneLength * 0.5f, LaneSpacing * 0.5f, 50.f));
+
+		float X = LaneMinX + Random.FRandRange(700.f, 1100.f);
+		bool bRightSide = Random.RandRange(0, 1) == 1;
+		while (X < LaneMaxX)
+		{
+			const float SegmentLength = FMath::Min(Random.FRandRange(800.f, 2000.f), LaneMaxX - X);
+			const float Side = bRightSide ? 1.f : -1.f;
+			AddBox(LaneOrigin + FVector(X + SegmentLength * 0.5f, Side * (WallOffset + WallThickness * 0.5f), WallHeight * 0.5f), FVector(SegmentLength * 0.5f, WallThickness * 0.5f, WallHeight * 0.5f));
+
+			X += SegmentLength + Random.FRandRange(300.f, 800.f);
+			bRightSide = !bRightSide;
+		}
+	}
+
+	return Course;
+}
+
+FVector FTutWallCourse::GetLaneStart(const FVector& Origin, int32 Lane)
+{
+	return Origin + FVector(0.f, Lane * LaneSpacing, 150.f);
+}
@@ -0,0 +1,37 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UWorld;
+class AMyCustomCharacter;
+
+/*
+* The scripted movement shared by the benchmark and the net soak harness. One cycle covers every custom feature:
+* 0-5s sprint (switching speed tier at 2.5s), jumps into wall runs and a wall jump around 1s and 3s, fly flag from 5-6s, launch at 7s.
+* All of it goes through the same calls the player's input would, so on a client it is predicted and sent to the server like real input.
+*/
+struct TUTORIALRESEARCH_API FTutMovementScript
+{
+	static constexpr float CycleSeconds = 8.f;
+
+	//Applies everything scheduled between PreviousPhase and Phase (both within [0, CycleSeconds), wrapping around is fine). Pass the same value twice to only apply held input.
+	static void Apply(AMyCustomCharacter* Character, float PreviousPhase, float Phase, const FVector& RunDirection);
+};
+
+/*
+* A wall running course made of plain box components, so it works on a cooked server with nothing but the engine.
+* Lanes run along X, side by side along Y. Each lane has a floor strip and walls on alternating sides, inside the range TryWallRun probes.
+* Nothing here is replicated. The same seed always builds the same course, so a server and its clients can each build their own identical copy.
+*/
+struct TUTORIALRESEARCH_API FTutWallCourse
+{
+	static constexpr float LaneSpacing = 400.f;
+
+	static AActor* Build(UWorld* World, const FVector& Origin, int32 NumLanes, float LaneMinX, float LaneMaxX, int32 Seed);
+
+	//Centre of the lane at X = 0, just above the floor.
+	static FVector GetLaneStart(const FVector& Origin, int32 Lane);
+};
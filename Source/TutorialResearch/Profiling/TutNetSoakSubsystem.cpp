@@ -0,0 +1,364 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutNetSoakSubsystem.h"
+#include "TutMovementScript.h"
+#include "../Character/MyCustomCharacter.h"
+#include "../Character/TutCharacterMovementComponent.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogTutNetSoak);
+
+const FVector UTutNetSoakSubsystem::CourseOrigin(0.f, 0.f, 50000.f);
+
+bool UTutNetSoakSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("TutNetSoak")) && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UTutNetSoakSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTutNetSoakSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FParse::Value(CommandLine, TEXT("TutNetSoakSeconds="), DurationSeconds);
+	FParse::Value(CommandLine, TEXT("TutNetSoakReport="), ReportSeconds);
+	FParse::Value(CommandLine, TEXT("TutNetSoakLanes="), NumLanes);
+	FParse::Value(CommandLine, TEXT("TutNetSoakBots="), NumBots);
+	FParse::Value(CommandLine, TEXT("TutNetSoakSeed="), Seed);
+	bQuantizeMoveData = FParse::Param(CommandLine, TEXT("TutNetSoakQuantize"));
+	bDeltaEncodeMoveData = FParse::Param(CommandLine, TEXT("TutNetSoakDeltaEncode"));
+	NumLanes = FMath::Max(NumLanes, 1);
+	NumBots = FMath::Clamp(NumBots, 0, 1000);
+	ReportSeconds = FMath::Max(ReportSeconds, 1.f);
+
+	//Every process builds its own copy. The seed makes them identical, so client and server agree on every wall.
+	FTutWallCourse::Build(&InWorld, CourseOrigin, NumLanes + NumBots, -LaneHalfLength, LaneHalfLength, Seed);
+
+	//Before the bots, so they get the same move data settings as everyone else.
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTutNetSoakSubsystem::OnActorSpawned));
+	for (TActorIterator<AMyCustomCharacter> It(&InWorld); It; ++It)
+	{
+		OnActorSpawned(*It);
+	}
+
+	if (InWorld.GetNetMode() != NM_Client)
+	{
+		SpawnBots();
+	}
+
+	//Only used on clients. Different per process so the clients aren't in lockstep.
+	PhaseOffset = FMath::FRandRange(0.f, FTutMovementScript::CycleSeconds);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UTutNetSoakSubsystem::OnPostActorTick);
+	PostTickFlushHandle = InWorld.OnPostTickFlush().AddUObject(this, &UTutNetSoakSubsystem::OnPostTickFlush);
+
+	const IConsoleVariable* PushModelCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("net.IsPushModelEnabled"));
+	const IConsoleVariable* IrisCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("net.Iris.UseIrisReplication"));
+	UE_LOG(LogTutNetSoak, Display, TEXT("Net soak started: %.0fs, reporting every %.0fs, %d lanes, %d bots, net mode %d, push model %d, Iris %d, quantize %d, delta encode %d."),
+		DurationSeconds, ReportSeconds, NumLanes, NumBots, (int32)InWorld.GetNetMode(), PushModelCVar ? PushModelCVar->GetInt() : 0, IrisCVar ? IrisCVar->GetInt() : 0,
+		bQuantizeMoveData, bDeltaEncodeMoveData);
+}
+
+void UTutNetSoakSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	GetWorld()->OnPostTickFlush().Remove(PostTickFlushHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	ReportedCounts.Empty();
+	Super::Deinitialize();
+}
+
+void UTutNetSoakSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (AMyCustomCharacter* Character = Cast<AMyCustomCharacter>(Actor))
+	{
+		if (UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement())
+		{
+			if (bQuantizeMoveData)
+			{
+				Movement->MoveDataQuantization.bQuantizeMoveData = true;
+			}
+			if (bDeltaEncodeMoveData)
+			{
+				Movement->bDeltaEncodeMoveData = true;
+			}
+		}
+	}
+}
+
+void UTutNetSoakSubsystem::OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		NetFlushStartCycles = FPlatformTime::Cycles64();
+	}
+}
+
+void UTutNetSoakSubsystem::OnPostTickFlush(float DeltaSeconds)
+{
+	if (NetFlushStartCycles != 0)
+	{
+		CurrentWindow.NetFlushMs += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - NetFlushStartCycles);
+		NetFlushStartCycles = 0;
+	}
+}
+
+TStatId UTutNetSoakSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTutNetSoakSubsystem, STATGROUP_Tickables);
+}
+
+void UTutNetSoakSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bFinished || !GetWorld()->HasBegunPlay())
+	{
+		return;
+	}
+
+	if (GetWorld()->GetNetMode() != NM_Client)
+	{
+		AssignLanes();
+		DriveBots(DeltaTime);
+	}
+	DriveLocalCharacter(DeltaTime);
+	Sample(DeltaTime);
+
+	Elapsed += DeltaTime;
+	if (CurrentWindow.Seconds >= ReportSeconds)
+	{
+		Report(TEXT("TutNetSoak"), CurrentWindow);
+		TotalWindow.Add(CurrentWindow);
+		CurrentWindow = FSoakWindow();
+
+		//Characters come and go (players reconnecting, respawns), don't keep counting for the ones that are gone.
+		for (auto It = ReportedCounts.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	if (Elapsed >= DurationSeconds)
+	{
+		TotalWindow.Add(CurrentWindow);
+		Report(TEXT("TutNetSoakSummary"), TotalWindow);
+		if (NumRecentres > 0)
+		{
+			UE_LOG(LogTutNetSoak, Display, TEXT("Characters moved back to the middle of their lane %d times. Each one costs a correction."), NumRecentres);
+		}
+		bFinished = true;
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UTutNetSoakSubsystem::AssignLanes()
+{
+	for (TActorIterator<AMyCustomCharacter> It(GetWorld()); It; ++It)
+	{
+		AMyCustomCharacter* Character = *It;
+		if (!Character->IsPlayerControlled())
+		{
+			continue;
+		}
+
+		const int32* Lane = Lanes.Find(Character);
+		if (!Lane)
+		{
+			Lane = &Lanes.Add(Character, NextLane++ % NumLanes);
+			Character->TeleportTo(FTutWallCourse::GetLaneStart(CourseOrigin, *Lane), FRotator::ZeroRotator);
+			continue;
+		}
+
+		NumRecentres += RecentreInLane(Character, *Lane);
+	}
+}
+
+bool UTutNetSoakSubsystem::RecentreInLane(AMyCustomCharacter* Character, int32 Lane) const
+{
+	//The script alternates direction every cycle, but sprint tiers and wall jumps still add up over a long run.
+	const FVector LaneStart = FTutWallCourse::GetLaneStart(CourseOrigin, Lane);
+	const FVector Location = Character->GetActorLocation();
+	if (FMath::Abs(Location.X - LaneStart.X) > LaneHalfLength - 1500.f || Location.Z < CourseOrigin.Z - 1000.f)
+	{
+		Character->TeleportTo(LaneStart, FRotator::ZeroRotator);
+		return true;
+	}
+	return false;
+}
+
+void UTutNetSoakSubsystem::SpawnBots()
+{
+	for (int32 Index = 0; Index < NumBots; ++Index)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AMyCustomCharacter* Bot = GetWorld()->SpawnActor<AMyCustomCharacter>(FTutWallCourse::GetLaneStart(CourseOrigin, NumLanes + Index), FRotator::ZeroRotator, SpawnParams);
+		if (!Bot)
+		{
+			continue;
+		}
+
+		//No controller, the server moves it like it would an AI character.
+		Bot->GetCustomCharacterMovement()->bRunPhysicsWithNoController = true;
+		Bots.Add(Bot);
+		BotPhaseOffsets.Add(FMath::FRandRange(0.f, FTutMovementScript::CycleSeconds));
+	}
+}
+
+void UTutNetSoakSubsystem::DriveBots(float DeltaTime)
+{
+	for (int32 Index = 0; Index < Bots.Num(); ++Index)
+	{
+		if (AMyCustomCharacter* Bot = Bots[Index].Get())
+		{
+			ApplyScript(Bot, Elapsed + BotPhaseOffsets[Index], DeltaTime);
+			NumRecentres += RecentreInLane(Bot, NumLanes + Index);
+		}
+	}
+}
+
+void UTutNetSoakSubsystem::ApplyScript(AMyCustomCharacter* Character, float ScriptTime, float DeltaTime)
+{
+	//Run one way for a cycle, then back the other way, so everyone stays near the middle of their lane.
+	const int32 Cycle = FMath::FloorToInt((ScriptTime + DeltaTime) / FTutMovementScript::CycleSeconds);
+	const FVector RunDirection = (Cycle % 2 == 0) ? FVector::ForwardVector : FVector::BackwardVector;
+	const float PreviousPhase = FMath::Fmod(ScriptTime, FTutMovementScript::CycleSeconds);
+	const float Phase = FMath::Fmod(ScriptTime + DeltaTime, FTutMovementScript::CycleSeconds);
+	FTutMovementScript::Apply(Character, PreviousPhase, Phase, RunDirection);
+}
+
+void UTutNetSoakSubsystem::DriveLocalCharacter(float DeltaTime)
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	AMyCustomCharacter* Character = PlayerController && PlayerController->IsLocalController() ? Cast<AMyCustomCharacter>(PlayerController->GetPawn()) : nullptr;
+	if (!Character)
+	{
+		return;
+	}
+
+	if (DrivenCharacter != Character)
+	{
+		DrivenCharacter = Character;
+		DriveTime = 0.f;
+	}
+
+	const float PreviousDriveTime = DriveTime;
+	DriveTime += DeltaTime;
+
+	static constexpr float StartDelay = 2.f;
+	if (PreviousDriveTime < StartDelay)
+	{
+		return;
+	}
+
+	ApplyScript(Character, PreviousDriveTime - StartDelay + PhaseOffset, DeltaTime);
+}
+
+void UTutNetSoakSubsystem::Sample(float DeltaTime)
+{
+	CurrentWindow.Seconds += DeltaTime;
+	CurrentWindow.GameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	++CurrentWindow.Frames;
+
+	if (const UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		//These are per second rates, updated once a second. Integrating them over the frame gives bytes.
+		CurrentWindow.OutBytes += uint64(NetDriver->OutBytesPerSecond * DeltaTime);
+		CurrentWindow.InBytes += uint64(NetDriver->InBytesPerSecond * DeltaTime);
+	}
+
+	const bool bIsClient = GetWorld()->GetNetMode() == NM_Client;
+	for (TActorIterator<AMyCustomCharacter> It(GetWorld()); It; ++It)
+	{
+		UTutCharacterMovementComponent* Movement = It->GetCustomCharacterMovement();
+		if (!Movement)
+		{
+			continue;
+		}
+
+		//Servers count the corrections they send, clients the ones they apply. Only the local character applies any.
+		const uint32 Corrections = bIsClient ? Movement->NumClientCorrections : Movement->NumServerCorrections;
+		FReportedCounts& Reported = ReportedCounts.FindOrAdd(Movement);
+		CurrentWindow.Corrections += Corrections - Reported.Corrections;
+		Reported.Corrections = Corrections;
+
+		//Only characters that save moves have a pool: the local character on a client, or a listen server host's.
+		if (const FCustomSavedMovePool::FCounters* PoolCounters = Movement->GetSavedMovePoolCounters())
+		{
+			CurrentWindow.SavedMoveRequests += PoolCounters->Requests - Reported.SavedMoveRequests;
+			CurrentWindow.SavedMoveAllocations += PoolCounters->Allocations - Reported.SavedMoveAllocations;
+			CurrentWindow.SavedMoveHeapFallbacks += PoolCounters->HeapFallbacks - Reported.SavedMoveHeapFallbacks;
+			CurrentWindow.SavedMovePoolHighWater = FMath::Max(CurrentWindow.SavedMovePoolHighWater, PoolCounters->HighWater);
+			Reported.SavedMoveRequests = PoolCounters->Requests;
+			Reported.SavedMoveAllocations = PoolCounters->Allocations;
+			Reported.SavedMoveHeapFallbacks = PoolCounters->HeapFallbacks;
+		}
+
+		//Only the local character sends moves.
+		CurrentWindow.ServerMovesSent += Movement->NumServerMovesSent - Reported.ServerMovesSent;
+		CurrentWindow.ServerMoveBitsSent += Movement->NumServerMoveBitsSent - Reported.ServerMoveBitsSent;
+		Reported.ServerMovesSent = Movement->NumServerMovesSent;
+		Reported.ServerMoveBitsSent = Movement->NumServerMoveBitsSent;
+
+		if (bIsClient && It->IsLocallyControlled())
+		{
+			if (const FNetworkPredictionData_Client_Character* ClientData = Movement->GetPredictionData_Client_Character())
+			{
+				const int32 Depth = ClientData->SavedMoves.Num();
+				CurrentWindow.SavedMoveTotal += Depth;
+				CurrentWindow.SavedMoveMax = FMath::Max(CurrentWindow.SavedMoveMax, Depth);
+				++CurrentWindow.SavedMoveSamples;
+			}
+		}
+	}
+}
+
+void UTutNetSoakSubsystem::Report(const TCHAR* Label, const FSoakWindow& Window) const
+{
+	const float Seconds = FMath::Max(Window.Seconds, KINDA_SMALL_NUMBER);
+	const TCHAR* Role = GetWorld()->GetNetMode() == NM_Client ? TEXT("Client") : TEXT("Server");
+	const double SavedMovesAvg = Window.SavedMoveSamples > 0 ? double(Window.SavedMoveTotal) / Window.SavedMoveSamples : 0.0;
+
+	const int32 Frames = FMath::Max(Window.Frames, 1);
+	const double MoveBits = Window.ServerMovesSent > 0 ? double(Window.ServerMoveBitsSent) / Window.ServerMovesSent : 0.0;
+
+	UE_LOG(LogTutNetSoak, Display, TEXT("%s Role=%s Seconds=%.0f CorrectionsPerMin=%.1f OutBytesPerSec=%.0f InBytesPerSec=%.0f GameThreadMs=%.2f NetFlushMs=%.3f SavedMovesAvg=%.1f SavedMovesMax=%d SavedMoveRequests=%u SavedMoveAllocations=%u SavedMoveHeapFallbacks=%u SavedMovePoolHighWater=%d MoveBits=%.1f"),
+		Label, Role, Window.Seconds, Window.Corrections * 60.f / Seconds, Window.OutBytes / Seconds, Window.InBytes / Seconds,
+		Window.GameThreadMs / Frames, Window.NetFlushMs / Frames, SavedMovesAvg, Window.SavedMoveMax,
+		Window.SavedMoveRequests, Window.SavedMoveAllocations, Window.SavedMoveHeapFallbacks, Window.SavedMovePoolHighWater, MoveBits);
+}
+
+void UTutNetSoakSubsystem::FSoakWindow::Add(const FSoakWindow& Other)
+{
+	Seconds += Other.Seconds;
+	Corrections += Other.Corrections;
+	GameThreadMs += Other.GameThreadMs;
+	NetFlushMs += Other.NetFlushMs;
+	Frames += Other.Frames;
+	SavedMoveSamples += Other.SavedMoveSamples;
+	SavedMoveTotal += Other.SavedMoveTotal;
+	SavedMoveMax = FMath::Max(SavedMoveMax, Other.SavedMoveMax);
+	SavedMoveRequests += Other.SavedMoveRequests;
+	SavedMoveAllocations += Other.SavedMoveAllocations;
+	SavedMoveHeapFallbacks += Other.SavedMoveHeapFallbacks;
+	SavedMovePoolHighWater = FMath::Max(SavedMovePoolHighWater, Other.SavedMovePoolHighWater);
+	ServerMovesSent += Other.ServerMovesSent;
+	ServerMoveBitsSent += Other.ServerMoveBitsSent;
+	OutBytes += Other.OutBytes;
+	InBytes += Other.InBytes;
+}
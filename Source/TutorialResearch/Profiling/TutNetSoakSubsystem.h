@@ -0,0 +1,141 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TutNetSoakSubsystem.generated.h"
+
+class AMyCustomCharacter;
+class UTutCharacterMovementComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogTutNetSoak, Log, All);
+
+/*
+* The in-game half of the network soak harness (see Scripts/NetSoak.sh). Only exists when the process is started with -TutNetSoak.
+*
+* Both the server and every client build the same wall course, far away from the map's own geometry.
+* The server moves each player's character to its own lane. Each client drives its own character through FTutMovementScript, exactly as if a player was pressing the buttons,
+* so everything goes through prediction, saved moves, ServerMove and corrections under whatever packet lag, loss and jitter the process was started with.
+*
+* Every report interval, each process logs a "TutNetSoak" line with:
+* corrections per minute, bytes sent and received per second, game thread time per frame, net flush time per frame (replication, on the server),
+* and on clients the saved move list depth, what the saved move pools were asked for (requests, heap allocations, the largest pool), and the average size of a ServerMovePacked.
+* A "TutNetSoakSummary" line covering the whole run is logged before the process exits.
+*
+* -TutNetSoakBots=N also has the server spawn N characters of its own, driven by the same script, on lanes after the players'.
+* They replicate to every client like players do, so replication cost can be measured for many characters without running a process for each one.
+*
+* -TutNetSoakQuantize and -TutNetSoakDeltaEncode turn on MoveDataQuantization and bDeltaEncodeMoveData for every character as it spawns.
+* Both ends have to agree on these, so pass them to the server and every client. Comparing MoveBits with and without them measures what they save on the same script.
+*
+* Options: -TutNetSoakSeconds=120 -TutNetSoakReport=10 -TutNetSoakLanes=16 -TutNetSoakBots=0 -TutNetSoakSeed=1337 -TutNetSoakQuantize -TutNetSoakDeltaEncode
+*/
+UCLASS()
+class UTutNetSoakSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FSoakWindow
+	{
+		float Seconds = 0.f;
+		uint32 Corrections = 0;
+		double GameThreadMs = 0.0;
+		double NetFlushMs = 0.0;
+		int32 Frames = 0;
+		int64 SavedMoveSamples = 0;
+		int64 SavedMoveTotal = 0;
+		int32 SavedMoveMax = 0;
+		uint32 SavedMoveRequests = 0;
+		uint32 SavedMoveAllocations = 0;
+		uint32 SavedMoveHeapFallbacks = 0;
+		int32 SavedMovePoolHighWater = 0;
+		uint32 ServerMovesSent = 0;
+		uint64 ServerMoveBitsSent = 0;
+		uint64 OutBytes = 0;
+		uint64 InBytes = 0;
+
+		void Add(const FSoakWindow& Other);
+	};
+
+	void AssignLanes();
+	void SpawnBots();
+	//Applies -TutNetSoakQuantize and -TutNetSoakDeltaEncode, before the character sends or receives its first move.
+	void OnActorSpawned(AActor* Actor);
+	void DriveBots(float DeltaTime);
+	void DriveLocalCharacter(float DeltaTime);
+	//Runs the script ScriptTime seconds in, alternating direction every cycle.
+	static void ApplyScript(AMyCustomCharacter* Character, float ScriptTime, float DeltaTime);
+	//Moves a character back to its lane start if it ran too far or fell off. Returns true if it did.
+	bool RecentreInLane(AMyCustomCharacter* Character, int32 Lane) const;
+	void Sample(float DeltaTime);
+	void Report(const TCHAR* Label, const FSoakWindow& Window) const;
+
+	//Brackets the net driver's TickFlush, which is where the server compares and sends replicated properties. Anything else between the two is small by comparison.
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush(float DeltaSeconds);
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+	FDelegateHandle ActorSpawnedHandle;
+	uint64 NetFlushStartCycles = 0;
+
+	//Far above the map, so the course doesn't collide with anything already there.
+	static const FVector CourseOrigin;
+	static constexpr float LaneHalfLength = 12000.f;
+
+	float DurationSeconds = 120.f;
+	float ReportSeconds = 10.f;
+	int32 NumLanes = 16;
+	int32 NumBots = 0;
+	int32 Seed = 1337;
+	bool bQuantizeMoveData = false;
+	bool bDeltaEncodeMoveData = false;
+
+	float Elapsed = 0.f;
+	bool bFinished = false;
+
+	//Server: which lane each player's character was given.
+	TMap<TWeakObjectPtr<AActor>, int32> Lanes;
+	int32 NextLane = 0;
+	int32 NumRecentres = 0;
+
+	//Server: characters it drives itself, and where in the script each one starts.
+	TArray<TWeakObjectPtr<AMyCustomCharacter>> Bots;
+	TArray<float> BotPhaseOffsets;
+
+	//Client: how long we have been driving our current character. Gives the server time to move us to our lane first.
+	TWeakObjectPtr<AActor> DrivenCharacter;
+	float DriveTime = 0.f;
+	float PhaseOffset = 0.f;
+
+	//Running totals each movement component had when it was last sampled, so each window only counts what happened during it.
+	struct FReportedCounts
+	{
+		uint32 Corrections = 0;
+		uint32 SavedMoveRequests = 0;
+		uint32 SavedMoveAllocations = 0;
+		uint32 SavedMoveHeapFallbacks = 0;
+		uint32 ServerMovesSent = 0;
+		uint64 ServerMoveBitsSent = 0;
+	};
+
+	//Pruned of destroyed components after every report, and emptied when the world goes away.
+	TMap<TWeakObjectPtr<UTutCharacterMovementComponent>, FReportedCounts> ReportedCounts;
+
+	FSoakWindow CurrentWindow;
+	FSoakWindow TotalWindow;
+};
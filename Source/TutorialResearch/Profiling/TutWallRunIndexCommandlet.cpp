@@ -0,0 +1,142 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "TutWallRunIndexCommandlet.h"
+#include "../Character/TutWallRunSurfaceIndex.h"
+#include "Engine/World.h"
+#include "Engine/LevelStreaming.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace TutWallRunIndex
+{
+	//Loads MapName with every one of its streaming levels, with components registered so their collision can be read.
+	static UWorld* LoadWorld(const FString& MapName)
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (!World)
+		{
+			return nullptr;
+		}
+
+		World->WorldType = EWorldType::Game;
+		World->AddToRoot();
+		if (!World->bIsWorldInitialized)
+		{
+			World->InitWorld(UWorld::InitializationValues()
+				.AllowAudioPlayback(false)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.CreateFXSystem(false)
+				.SetTransactional(false));
+		}
+		World->UpdateWorldComponents(true, false);
+
+		//Walls in sublevels count too.
+		for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+		{
+			if (StreamingLevel)
+			{
+				StreamingLevel->SetShouldBeLoaded(true);
+				StreamingLevel->SetShouldBeVisible(true);
+			}
+		}
+		World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+		return World;
+	}
+}
+
+UTutWallRunIndexCommandlet::UTutWallRunIndexCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTutWallRunIndexCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	using namespace TutWallRunIndex;
+
+	FString MapList;
+	FParse::Value(*Params, TEXT("Map="), MapList);
+	TArray<FString> MapNames;
+	MapList.ParseIntoArray(MapNames, TEXT("+"));
+	if (MapNames.Num() == 0)
+	{
+		UE_LOG(LogTutWallRunIndex, Error, TEXT("Pass the map(s) to bake with -Map=/Game/...(+/Game/...)."));
+		return 2;
+	}
+
+	FTutWallRunSurfaceBuildSettings BuildSettings;
+	FParse::Value(*Params, TEXT("CellSize="), BuildSettings.CellSize);
+	const bool bDryRun = FParse::Param(*Params, TEXT("DryRun"));
+
+	for (const FString& MapName : MapNames)
+	{
+		UWorld* World = LoadWorld(MapName);
+		if (!World)
+		{
+			UE_LOG(LogTutWallRunIndex, Error, TEXT("Couldn't load map '%s'."), *MapName);
+			return 2;
+		}
+		if (World->IsPartitionedWorld())
+		{
+			UE_LOG(LogTutWallRunIndex, Warning, TEXT("%s uses world partition. Only its always loaded actors are indexed."), *MapName);
+		}
+
+		const FString MapPackageName = World->GetOutermost()->GetName();
+		const FString IndexPackageName = UTutWallRunSurfaceIndex::GetPackageNameForMap(MapPackageName);
+		const FString IndexAssetName = FPackageName::GetShortName(IndexPackageName);
+
+		//Rebuild the existing asset if there is one, so anything referring to it keeps working.
+		UPackage* IndexPackage = FPackageName::DoesPackageExist(IndexPackageName) ? LoadPackage(nullptr, *IndexPackageName, LOAD_None) : nullptr;
+		if (!IndexPackage)
+		{
+			IndexPackage = CreatePackage(*IndexPackageName);
+		}
+		UTutWallRunSurfaceIndex* Index = FindObject<UTutWallRunSurfaceIndex>(IndexPackage, *IndexAssetName);
+		if (!Index)
+		{
+			Index = NewObject<UTutWallRunSurfaceIndex>(IndexPackage, *IndexAssetName, RF_Public | RF_Standalone);
+		}
+
+		const double StartSeconds = FPlatformTime::Seconds();
+		Index->Build(World, BuildSettings);
+		const double BuildMilliseconds = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+		World->RemoveFromRoot();
+		World->DestroyWorld(false);
+		//The index is standalone, so only the map goes.
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		UE_LOG(LogTutWallRunIndex, Display, TEXT("%s: %d wall run surfaces in %d cells, %.1f KB, built in %.1f ms."),
+			*MapPackageName, Index->GetNumSurfaces(), Index->GetNumCells(), Index->GetResourceSizeBytes(EResourceSizeMode::Exclusive) / 1024.0, BuildMilliseconds);
+
+		if (bDryRun)
+		{
+			continue;
+		}
+
+		IndexPackage->MarkPackageDirty();
+		const FString Filename = FPackageName::LongPackageNameToFilename(IndexPackageName, FPackageName::GetAssetPackageExtension());
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		SaveArgs.SaveFlags = SAVE_NoError;
+		if (!UPackage::SavePackage(IndexPackage, Index, *Filename, SaveArgs))
+		{
+			UE_LOG(LogTutWallRunIndex, Error, TEXT("Couldn't save %s. Is it checked out?"), *Filename);
+			return 2;
+		}
+		UE_LOG(LogTutWallRunIndex, Display, TEXT("Saved %s"), *Filename);
+	}
+
+	return 0;
+#else
+	UE_LOG(LogTutWallRunIndex, Error, TEXT("The wall run surface index can only be baked by an editor build."));
+	return 2;
+#endif
+}
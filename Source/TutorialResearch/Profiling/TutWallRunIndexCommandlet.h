@@ -0,0 +1,34 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TutWallRunIndexCommandlet.generated.h"
+
+/*
+* Bakes the wall run surface index (UTutWallRunSurfaceIndex) of one or more maps, which TryWallRun checks before it traces for a wall.
+* Loads each map with all of its streaming levels, scans their collision for faces a wall probe could hit, and saves the index next to the map as <Map>_WallRunIndex.
+*
+* Usage (editor binary, since it saves packages):
+* UnrealEditor-Cmd TutorialResearch.uproject -run=TutWallRunIndex -nullrhi -unattended -Map=/Game/ThirdPerson/Maps/ThirdPersonMap
+*
+* Optional switches:
+* -Map=A+B to bake several maps in one go.
+* -CellSize= overrides the default in FTutWallRunSurfaceBuildSettings.
+* -DryRun builds and reports without saving anything.
+*
+* Run it as part of the content build, after any change to level collision. World partition maps only get their always loaded actors indexed.
+* Returns 0 on success, 2 if a map couldn't be loaded or its index couldn't be saved.
+*/
+UCLASS()
+class UTutWallRunIndexCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UTutWallRunIndexCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
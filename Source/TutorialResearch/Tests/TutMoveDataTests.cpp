@@ -0,0 +1,177 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "../Character/TutCharacterMovementComponent.h"
+#include "UObject/CoreNet.h"
+#include "UObject/Package.h"
+
+namespace TutMoveDataTests
+{
+	//Bits Ar << Value writes. What SerializeOptionalValue spends on a value that differs from its default.
+	template<typename ValueType>
+	static int64 BitsOf(ValueType Value)
+	{
+		FNetBitWriter Writer(nullptr, 1024);
+		Writer << Value;
+		return Writer.GetNumBits();
+	}
+
+	static const FVector TestLaunches[] = { FVector::ZeroVector, FVector(350.f, -1200.5f, 2400.f) };
+	static const uint8 TestTiers[] = { 0, 1, 15 };
+	static const uint8 TestFlags[] = { 0, (uint8)EMovementFlag::CFLAG_WantsToFly, 0x0F };
+}
+
+/*
+* Writes every combination of our custom move data (sprint, speed tier, flags, launch), at full precision and quantized, and reads it back.
+* Checks that each field survives the trip, and that the custom fields cost exactly what the comments on Serialize and SerializeQuantized say.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTutMoveDataRoundTripTest, "TutorialResearch.Movement.MoveData.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTutMoveDataRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace TutMoveDataTests;
+
+	UTutCharacterMovementComponent* Movement = NewObject<UTutCharacterMovementComponent>(GetTransientPackage());
+	const FCustomMoveDataQuantization& Quantization = Movement->MoveDataQuantization;
+
+	//The engine's part of the move, identical in every case. Everything beyond its bits is ours.
+	FCharacterNetworkMoveData EngineMove;
+	EngineMove.TimeStamp = 1.f;
+	FNetBitWriter EngineWriter(nullptr, 1024);
+	EngineMove.Serialize(*Movement, EngineWriter, nullptr, FCharacterNetworkMoveData::ENetworkMoveType::NewMove);
+	const int64 EngineBits = EngineWriter.GetNumBits();
+
+	for (const bool bQuantize : { false, true })
+	{
+		Movement->MoveDataQuantization.bQuantizeMoveData = bQuantize;
+
+		for (const bool bWantsToSprint : { false, true })
+		for (const uint8 Tier : TestTiers)
+		for (const uint8 Flags : TestFlags)
+		for (const FVector& Launch : TestLaunches)
+		{
+			const FString Case = FString::Printf(TEXT("Quantize=%d Sprint=%d Tier=%d Flags=0x%02x Launch=%s"), bQuantize, bWantsToSprint, Tier, Flags, *Launch.ToString());
+
+			FCustomNetworkMoveData Sent;
+			Sent.TimeStamp = EngineMove.TimeStamp;
+			Sent.bWantsToSprintMoveData = bWantsToSprint;
+			Sent.MovementFlagCustomMoveData = (Tier << UTutCharacterMovementComponent::SpeedTierShift) | Flags;
+			Sent.LaunchVelocityCustomMoveData = Launch;
+
+			FNetBitWriter Writer(nullptr, 1024);
+			Sent.Serialize(*Movement, Writer, nullptr, FCharacterNetworkMoveData::ENetworkMoveType::NewMove);
+			if (!TestFalse(*FString::Printf(TEXT("%s: write error"), *Case), Writer.IsError()))
+			{
+				continue;
+			}
+
+			FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+			FCustomNetworkMoveData Received;
+			Received.Serialize(*Movement, Reader, nullptr, FCharacterNetworkMoveData::ENetworkMoveType::NewMove);
+			TestFalse(*FString::Printf(TEXT("%s: read error"), *Case), Reader.IsError());
+			TestEqual(*FString::Printf(TEXT("%s: bits left unread"), *Case), Reader.GetBitsLeft(), (int64)0);
+
+			TestEqual(*FString::Printf(TEXT("%s: sprint"), *Case), Received.bWantsToSprintMoveData, bWantsToSprint);
+			TestEqual(*FString::Printf(TEXT("%s: flags"), *Case), Received.MovementFlagCustomMoveData, Sent.MovementFlagCustomMoveData);
+			TestEqual(*FString::Printf(TEXT("%s: tier"), *Case), (Received.MovementFlagCustomMoveData & UTutCharacterMovementComponent::SpeedTierMask) >> UTutCharacterMovementComponent::SpeedTierShift, (int32)Tier);
+			const FVector ExpectedLaunch = bQuantize ? Quantization.RoundLaunchVelocity(Launch) : Launch;
+			TestEqual(*FString::Printf(TEXT("%s: launch"), *Case), Received.LaunchVelocityCustomMoveData, ExpectedLaunch, 0.f);
+
+			int64 ExpectedBits = EngineBits;
+			if (bQuantize)
+			{
+				ExpectedBits += 1;
+				ExpectedBits += 1 + (Launch.IsZero() ? 0 : 3 * Quantization.LaunchVelocityBitsPerComponent);
+			}
+			else
+			{
+				ExpectedBits += 1 + (bWantsToSprint ? BitsOf(bWantsToSprint) : 0);
+				ExpectedBits += 1 + (Launch.IsZero() ? 0 : BitsOf(Launch));
+			}
+			ExpectedBits += 1 + (Sent.MovementFlagCustomMoveData != 0 ? 8 : 0);
+			TestEqual(*FString::Printf(TEXT("%s: bits"), *Case), Writer.GetNumBits(), ExpectedBits);
+		}
+	}
+
+	return true;
+}
+
+/*
+* The same for the custom state a correction carries: wall side, flags with the speed tier, pending launch and probe cooldown.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTutMoveResponseRoundTripTest, "TutorialResearch.Movement.MoveData.ResponseRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTutMoveResponseRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace TutMoveDataTests;
+
+	UTutCharacterMovementComponent* Movement = NewObject<UTutCharacterMovementComponent>(GetTransientPackage());
+	const FCustomMoveDataQuantization& Quantization = Movement->MoveDataQuantization;
+
+	FClientAdjustment Correction;
+	Correction.bAckGoodMove = false;
+	Correction.TimeStamp = 1.f;
+	Correction.NewLoc = FVector(100.f, 200.f, 300.f);
+	Correction.MovementMode = MOVE_Falling;
+
+	FCharacterMoveResponseDataContainer EngineResponse;
+	EngineResponse.ClientAdjustment = Correction;
+	FNetBitWriter EngineWriter(nullptr, 1024);
+	EngineResponse.Serialize(*Movement, EngineWriter, nullptr);
+	const int64 EngineBits = EngineWriter.GetNumBits();
+
+	for (const bool bQuantize : { false, true })
+	{
+		Movement->MoveDataQuantization.bQuantizeMoveData = bQuantize;
+
+		for (const bool bWallRunIsRight : { false, true })
+		for (const uint8 Tier : TestTiers)
+		for (const uint8 Flags : TestFlags)
+		for (const FVector& Launch : TestLaunches)
+		for (const float Cooldown : { 0.f, Movement->WallRunProbeCooldown * 0.5f })
+		{
+			const FString Case = FString::Printf(TEXT("Quantize=%d WallRunIsRight=%d Tier=%d Flags=0x%02x Launch=%s Cooldown=%.3f"), bQuantize, bWallRunIsRight, Tier, Flags, *Launch.ToString(), Cooldown);
+
+			FCustomCharacterMoveResponseDataContainer Sent;
+			Sent.ClientAdjustment = Correction;
+			Sent.CustomResponseData.bWallRunIsRight = bWallRunIsRight;
+			Sent.CustomResponseData.MovementFlagCustom = (Tier << UTutCharacterMovementComponent::SpeedTierShift) | Flags;
+			Sent.CustomResponseData.PendingLaunchVelocity = Launch;
+			Sent.CustomResponseData.WallRunProbeCooldownRemaining = Cooldown;
+
+			FNetBitWriter Writer(nullptr, 1024);
+			if (!TestTrue(*FString::Printf(TEXT("%s: write"), *Case), Sent.Serialize(*Movement, Writer, nullptr)))
+			{
+				continue;
+			}
+
+			FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+			FCustomCharacterMoveResponseDataContainer Received;
+			TestTrue(*FString::Printf(TEXT("%s: read"), *Case), Received.Serialize(*Movement, Reader, nullptr));
+			TestEqual(*FString::Printf(TEXT("%s: bits left unread"), *Case), Reader.GetBitsLeft(), (int64)0);
+
+			const FCustomMoveResponseData& Data = Received.CustomResponseData;
+			TestEqual(*FString::Printf(TEXT("%s: wall side"), *Case), Data.bWallRunIsRight, bWallRunIsRight);
+			TestEqual(*FString::Printf(TEXT("%s: flags"), *Case), Data.MovementFlagCustom, Sent.CustomResponseData.MovementFlagCustom);
+			const FVector ExpectedLaunch = bQuantize ? Quantization.RoundLaunchVelocity(Launch) : Launch;
+			TestEqual(*FString::Printf(TEXT("%s: launch"), *Case), Data.PendingLaunchVelocity, ExpectedLaunch, 0.f);
+			//8 bits over the full cooldown.
+			TestEqual(*FString::Printf(TEXT("%s: cooldown"), *Case), Data.WallRunProbeCooldownRemaining, Cooldown, Movement->WallRunProbeCooldown / 255.f);
+
+			int64 ExpectedBits = EngineBits + 1;
+			ExpectedBits += 1 + (Sent.CustomResponseData.MovementFlagCustom != 0 ? 8 : 0);
+			ExpectedBits += 1 + (Launch.IsZero() ? 0 : (bQuantize ? 3 * Quantization.LaunchVelocityBitsPerComponent : BitsOf(Launch)));
+			ExpectedBits += 1 + (Cooldown > 0.f ? 8 : 0);
+			TestEqual(*FString::Printf(TEXT("%s: bits"), *Case), Writer.GetNumBits(), ExpectedBits);
+		}
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,136 @@
+// CMC Tutorial Copyright (c) 2023 Kyle Lautenbach
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "../Character/MyCustomCharacter.h"
+#include "../Character/TutCharacterMovementComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+namespace TutSavedMoveTests
+{
+	//A standalone world with one character in it, torn down when this goes out of scope. Same setup as the movement benchmark.
+	struct FTestWorld
+	{
+		FTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("TutSavedMoveTests"));
+			GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+			World->InitializeActorsForPlay(FURL());
+			World->GetWorldSettings()->NotifyBeginPlay();
+
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			Character = World->SpawnActor<AMyCustomCharacter>(FVector(0.f, 0.f, 500.f), FRotator::ZeroRotator, SpawnParams);
+		}
+
+		~FTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		UWorld* World = nullptr;
+		AMyCustomCharacter* Character = nullptr;
+	};
+}
+
+/*
+* Two falling moves a frame apart, with the wall probe cooldown running. They only differ in the cooldown, so they combine.
+* The combined move has to start from the first move's cooldown, both when it is first played and when it is replayed after a correction,
+* because that is where the server starts it from.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTutSavedMoveCombineProbeCooldownTest, "TutorialResearch.Movement.SavedMoves.CombineRestoresProbeCooldown",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTutSavedMoveCombineProbeCooldownTest::RunTest(const FString& Parameters)
+{
+	using namespace TutSavedMoveTests;
+
+	FTestWorld TestWorld;
+	if (!TestNotNull(TEXT("Character"), TestWorld.Character))
+	{
+		return false;
+	}
+
+	AMyCustomCharacter* Character = TestWorld.Character;
+	UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+	Movement->SetMovementMode(MOVE_Falling);
+	FNetworkPredictionData_Client_Character* ClientData = static_cast<FNetworkPredictionData_Client_Character*>(Movement->GetPredictionData_Client());
+
+	const float DeltaTime = 1.f / 60.f;
+	const float OldMoveCooldown = 0.05f;
+	const FVector Acceleration(1000.f, 0.f, 0.f);
+
+	Movement->WallRunProbeCooldownRemaining = OldMoveCooldown;
+	FSavedMovePtr OldMove = ClientData->CreateSavedMove();
+	OldMove->SetMoveFor(Character, DeltaTime, Acceleration, *ClientData);
+
+	//What playing OldMove does to the cooldown.
+	Movement->WallRunProbeCooldownRemaining = OldMoveCooldown - DeltaTime;
+	FSavedMovePtr NewMove = ClientData->CreateSavedMove();
+	NewMove->SetMoveFor(Character, DeltaTime, Acceleration, *ClientData);
+
+	TestTrue(TEXT("Moves that only differ in the probe cooldown combine"), OldMove->CanCombineWith(NewMove, Character, ClientData->MaxMoveDeltaTime));
+
+	NewMove->CombineWith(OldMove.Get(), Character, nullptr, OldMove->StartLocation);
+	const FCustomSavedMove& CombinedMove = static_cast<const FCustomSavedMove&>(*NewMove);
+	TestEqual(TEXT("Cooldown the combined move is played from"), Movement->WallRunProbeCooldownRemaining, OldMoveCooldown);
+	TestEqual(TEXT("Cooldown saved in the combined move"), CombinedMove.SavedWallRunProbeCooldown, OldMoveCooldown);
+
+	//Play it, then replay it, as ClientUpdatePositionAfterServerUpdate does with every move the server hasn't acknowledged yet.
+	Movement->WallRunProbeCooldownRemaining = FMath::Max(OldMoveCooldown - CombinedMove.DeltaTime, 0.f);
+	NewMove->PrepMoveFor(Character);
+	TestEqual(TEXT("Cooldown the combined move is replayed from"), Movement->WallRunProbeCooldownRemaining, OldMoveCooldown);
+
+	return true;
+}
+
+/*
+* A launch may only be the last thing in a combined move. If the pending move carries one, it was already handed to PendingLaunchVelocity,
+* and combining would make the server apply it a move later than the client did.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTutSavedMoveCombineLaunchTest, "TutorialResearch.Movement.SavedMoves.CombineLaunch",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTutSavedMoveCombineLaunchTest::RunTest(const FString& Parameters)
+{
+	using namespace TutSavedMoveTests;
+
+	FTestWorld TestWorld;
+	if (!TestNotNull(TEXT("Character"), TestWorld.Character))
+	{
+		return false;
+	}
+
+	AMyCustomCharacter* Character = TestWorld.Character;
+	UTutCharacterMovementComponent* Movement = Character->GetCustomCharacterMovement();
+	Movement->SetMovementMode(MOVE_Falling);
+	FNetworkPredictionData_Client_Character* ClientData = static_cast<FNetworkPredictionData_Client_Character*>(Movement->GetPredictionData_Client());
+
+	const float DeltaTime = 1.f / 60.f;
+	const FVector Acceleration(1000.f, 0.f, 0.f);
+	const FVector Launch(0.f, 0.f, 0.001f);
+
+	auto MakeMove = [&](const FVector& LaunchVelocity)
+	{
+		Movement->LaunchVelocityCustom = LaunchVelocity;
+		FSavedMovePtr Move = ClientData->CreateSavedMove();
+		Move->SetMoveFor(Character, DeltaTime, Acceleration, *ClientData);
+		return Move;
+	};
+
+	FSavedMovePtr NoLaunch = MakeMove(FVector::ZeroVector);
+	FSavedMovePtr WithLaunch = MakeMove(Launch);
+	FSavedMovePtr NoLaunchAfter = MakeMove(FVector::ZeroVector);
+
+	TestTrue(TEXT("A launch in the new move combines"), NoLaunch->CanCombineWith(WithLaunch, Character, ClientData->MaxMoveDeltaTime));
+	TestFalse(TEXT("A launch in the pending move doesn't, however small"), WithLaunch->CanCombineWith(NoLaunchAfter, Character, ClientData->MaxMoveDeltaTime));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -8,6 +8,9 @@ public class TutorialResearch : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "EnhancedInput" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "EnhancedInput", "NetCore", "NavigationSystem", "AIModule" });
+
+		//Iris replication, used when net.Iris.UseIrisReplication=1. Adds the IrisCore dependency and defines UE_WITH_IRIS.
+		SetupIrisSupport(Target);
 	}
 }